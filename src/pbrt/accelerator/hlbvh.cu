@@ -170,6 +170,8 @@ __global__ void init_bvh_args(HLBVH::BottomBVHArgs *bvh_args_array,
 
 const HLBVH *HLBVH::create(const std::vector<const Primitive *> &gpu_primitives,
                            GPUMemoryAllocator &allocator) {
+    GPUMemoryAllocator::Scope memory_scope(MemoryCategory::BVH);
+
     auto bvh = allocator.allocate<HLBVH>();
     bvh->build_bvh(gpu_primitives, allocator);
 
@@ -400,7 +402,11 @@ void HLBVH::build_bvh(const std::vector<const Primitive *> &gpu_primitives,
 
     auto sparse_treelets = local_allocator.allocate<Treelet>(MAX_TREELET_NUM);
 
-    auto gpu_morton_primitives = allocator.allocate<MortonPrimitive>(num_total_primitives);
+    MortonPrimitive *gpu_morton_primitives = nullptr;
+    {
+        GPUMemoryAllocator::Scope memory_scope(MemoryCategory::MortonPrimitives);
+        gpu_morton_primitives = allocator.allocate<MortonPrimitive>(num_total_primitives);
+    }
     auto gpu_primitives_array = allocator.allocate<const Primitive *>(num_total_primitives);
 
     CHECK_CUDA_ERROR(cudaMemcpy(gpu_primitives_array, gpu_primitives.data(),
@@ -487,7 +493,11 @@ void HLBVH::build_bvh(const std::vector<const Primitive *> &gpu_primitives,
         CHECK_CUDA_ERROR(cudaDeviceSynchronize());
     }
 
-    auto buffer_morton_primitives = local_allocator.allocate<MortonPrimitive>(num_total_primitives);
+    MortonPrimitive *buffer_morton_primitives = nullptr;
+    {
+        GPUMemoryAllocator::Scope memory_scope(MemoryCategory::MortonPrimitives);
+        buffer_morton_primitives = local_allocator.allocate<MortonPrimitive>(num_total_primitives);
+    }
     {
         const uint blocks = divide_and_ceil(num_total_primitives, threads);
         sort_morton_primitives<<<blocks, threads>>>(buffer_morton_primitives, morton_primitives,
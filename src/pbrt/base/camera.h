@@ -103,6 +103,9 @@ struct CameraBase {
     Vector3f minPosDifferentialX, minPosDifferentialY;
     Vector3f minDirDifferentialX, minDirDifferentialY;
 
+    // width of a pixel projected onto the plane at unit distance in front of the camera
+    FloatType pixel_size_at_unit_distance = 0;
+
     PBRT_CPU_GPU CameraBase() {}
 
     void init(const Point2i _resolution, const CameraTransform &_camera_transform) {
@@ -1,6 +1,7 @@
 #include <ext/lodepng/lodepng.h>
 #include <pbrt/base/film.h>
 #include <pbrt/films/rgb_film.h>
+#include <pbrt/films/unnormalized_film.h>
 #include <pbrt/spectrum_util/color_encoding.h>
 #include <pbrt/gpu/gpu_memory_allocator.h>
 #include <vector>
@@ -91,6 +92,18 @@ void Film::add_splat(const Point2f &p_film, const SampledSpectrum &radiance_l,
     REPORT_FATAL_ERROR();
 }
 
+PBRT_CPU_GPU
+bool Film::is_converged(const uint pixel_index, const FloatType noise_threshold) const {
+    switch (type) {
+    case Type::rgb: {
+        return static_cast<const RGBFilm *>(ptr)->is_converged(pixel_index, noise_threshold);
+    }
+    }
+
+    REPORT_FATAL_ERROR();
+    return false;
+}
+
 PBRT_CPU_GPU
 RGB Film::get_pixel_rgb(const Point2i &p, FloatType splat_scale) const {
     switch (type) {
@@ -103,6 +116,17 @@ RGB Film::get_pixel_rgb(const Point2i &p, FloatType splat_scale) const {
     return {};
 }
 
+Pixel *Film::get_pixels() const {
+    switch (type) {
+    case Type::rgb: {
+        return static_cast<const RGBFilm *>(ptr)->get_pixels();
+    }
+    }
+
+    REPORT_FATAL_ERROR();
+    return nullptr;
+}
+
 __global__ void copy_pixels(uint8_t *gpu_frame_buffer, const Film *film, uint width, uint height,
                             FloatType splat_scale) {
     const uint worker_idx = blockIdx.x * blockDim.x + threadIdx.x;
@@ -179,3 +203,19 @@ void Film::write_to_png(const std::string &filename, FloatType splat_scale) cons
         throw std::runtime_error("lodepng::encode() fail");
     }
 }
+
+void Film::write_unnormalized(const std::string &filename, const FloatType splat_spp,
+                              const std::pair<uint, uint> &sample_range,
+                              const uint total_spp) const {
+    switch (type) {
+    case Type::rgb: {
+        auto film = static_cast<const RGBFilm *>(ptr)->to_unnormalized(splat_spp);
+        film.total_spp = total_spp;
+        film.sample_ranges = {{sample_range.first, sample_range.second}};
+        film.write(filename);
+        return;
+    }
+    }
+
+    REPORT_FATAL_ERROR();
+}
@@ -9,6 +9,7 @@ class Filter;
 class GPUMemoryAllocator;
 class ParameterDictionary;
 class RGBFilm;
+struct Pixel;
 
 class Film {
   public:
@@ -42,13 +43,25 @@ class Film {
     void add_splat(const Point2f &p_film, const SampledSpectrum &radiance_l,
                    const SampledWavelengths &lambda);
 
+    // whether the pixel's relative error has dropped below noise_threshold
+    PBRT_CPU_GPU
+    bool is_converged(uint pixel_index, FloatType noise_threshold) const;
+
     PBRT_CPU_GPU
     RGB get_pixel_rgb(const Point2i &p, FloatType splat_scale = 1) const;
 
+    // raw accumulators of all pixels in row-major order (CPU only)
+    Pixel *get_pixels() const;
+
     void copy_to_frame_buffer(uint8_t *gpu_frame_buffer, FloatType splat_scale = 1) const;
 
     void write_to_png(const std::string &filename, FloatType splat_scale = 1) const;
 
+    // raw accumulators for pbrt-merge, splat_spp is the samples per pixel behind the splats and
+    // sample_range the part of the total_spp samples rendered
+    void write_unnormalized(const std::string &filename, FloatType splat_spp,
+                            const std::pair<uint, uint> &sample_range, uint total_spp) const;
+
   private:
     Type type;
     void *ptr;
@@ -8,6 +8,7 @@
 void FloatTexture::init(const FloatConstantTexture *float_constant_texture) {
     type = Type::constant;
     ptr = float_constant_texture;
+    constant_value = float_constant_texture->get_value();
 }
 
 void FloatTexture::init(const FloatImageTexture *float_image_texture) {
@@ -72,7 +73,7 @@ PBRT_CPU_GPU
 FloatType FloatTexture::evaluate(const TextureEvalContext &ctx) const {
     switch (type) {
     case Type::constant: {
-        return static_cast<const FloatConstantTexture *>(ptr)->evaluate(ctx);
+        return constant_value;
     }
 
     case Type::image: {
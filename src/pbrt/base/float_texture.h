@@ -40,4 +40,7 @@ class FloatTexture {
   private:
     Type type;
     const void *ptr;
+
+    // a copy of the constant texture's value, read without chasing `ptr`
+    FloatType constant_value;
 };
@@ -9,16 +9,6 @@
 #include <pbrt/scene/parameter_dictionary.h>
 #include <pbrt/spectrum_util/global_spectra.h>
 
-template <typename TypeOfLight>
-static __global__ void init_lights(Light *lights, TypeOfLight *concrete_lights, uint num) {
-    const uint worker_idx = blockIdx.x * blockDim.x + threadIdx.x;
-    if (worker_idx >= num) {
-        return;
-    }
-
-    lights[worker_idx].init(&concrete_lights[worker_idx]);
-}
-
 Light *Light::create(const std::string &type_of_light, const Transform &render_from_light,
                      const ParameterDictionary &parameters, GPUMemoryAllocator &allocator) {
     auto light = allocator.allocate<Light>();
@@ -62,21 +52,30 @@ Light *Light::create(const std::string &type_of_light, const Transform &render_f
     return nullptr;
 }
 
+static __global__ void init_diffuse_area_lights(Light *lights,
+                                                 DiffuseAreaLight *diffuse_area_lights,
+                                                 const AreaLightEmission *emission, uint num) {
+    const uint worker_idx = blockIdx.x * blockDim.x + threadIdx.x;
+    if (worker_idx >= num) {
+        return;
+    }
+
+    diffuse_area_lights[worker_idx].init(emission, worker_idx);
+    lights[worker_idx].init(&diffuse_area_lights[worker_idx]);
+}
+
 Light *Light::create_diffuse_area_lights(const Shape *shapes, const uint num,
-                                         const Transform &render_from_light,
                                          const ParameterDictionary &parameters,
                                          GPUMemoryAllocator &allocator) {
     constexpr uint threads = 1024;
     const uint blocks = divide_and_ceil(num, threads);
 
+    const auto emission = AreaLightEmission::create(shapes, parameters, allocator);
+
     auto diffuse_area_lights = allocator.allocate<DiffuseAreaLight>(num);
     auto lights = allocator.allocate<Light>(num);
 
-    for (uint idx = 0; idx < num; idx++) {
-        diffuse_area_lights[idx].init(&shapes[idx], render_from_light, parameters, allocator);
-    }
-
-    init_lights<<<blocks, threads>>>(lights, diffuse_area_lights, num);
+    init_diffuse_area_lights<<<blocks, threads>>>(lights, diffuse_area_lights, emission, num);
     CHECK_CUDA_ERROR(cudaGetLastError());
     CHECK_CUDA_ERROR(cudaDeviceSynchronize());
 
@@ -124,8 +124,8 @@ class Light {
     static Light *create(const std::string &type_of_light, const Transform &render_from_light,
                          const ParameterDictionary &parameters, GPUMemoryAllocator &allocator);
 
+    // one Light per shape, all sharing a single AreaLightEmission
     static Light *create_diffuse_area_lights(const Shape *shapes, const uint num,
-                                             const Transform &render_from_light,
                                              const ParameterDictionary &parameters,
                                              GPUMemoryAllocator &allocator);
 
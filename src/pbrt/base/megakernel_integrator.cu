@@ -12,8 +12,10 @@
 #include <thread>
 
 PBRT_GPU
-static void evaluate_pixel_sample(Film *film, const Point2i p_pixel, const uint samples_per_pixel,
-                                  Sampler *samplers, const MegakernelIntegrator *integrator,
+static void evaluate_pixel_sample(Film *film, const Point2i p_pixel, const uint first_sample_idx,
+                                  const uint last_sample_idx, const FloatType noise_threshold,
+                                  Sampler *samplers,
+                                  const MegakernelIntegrator *integrator,
                                   const IntegratorBase *integrator_base) {
     auto resolution = film->get_resolution();
     int width = resolution.x;
@@ -24,7 +26,11 @@ static void evaluate_pixel_sample(Film *film, const Point2i p_pixel, const uint
     auto camera = integrator_base->camera;
     auto filter = integrator_base->filter;
 
-    for (uint i = 0; i < samples_per_pixel; ++i) {
+    for (uint i = first_sample_idx; i < last_sample_idx; ++i) {
+        if (noise_threshold > 0 && film->is_converged(pixel_index, noise_threshold)) {
+            break;
+        }
+
         local_sampler->start_pixel_sample(pixel_index, i, 0);
         auto camera_sample = local_sampler->get_camera_sample(p_pixel, filter);
         auto lu = local_sampler->get_1d();
@@ -43,7 +49,8 @@ static void evaluate_pixel_sample(Film *film, const Point2i p_pixel, const uint
 }
 
 __global__ static void megakernel_render(Film *film, uint8_t *gpu_frame_buffer, int *counter,
-                                         const uint samples_per_pixel, Sampler *samplers,
+                                         const uint first_sample_idx, const uint last_sample_idx,
+                                         const FloatType noise_threshold, Sampler *samplers,
                                          const MegakernelIntegrator *integrator,
                                          const IntegratorBase *integrator_base) {
     const auto resolution = film->get_resolution();
@@ -55,8 +62,8 @@ __global__ static void megakernel_render(Film *film, uint8_t *gpu_frame_buffer,
         return;
     }
 
-    evaluate_pixel_sample(film, Point2i(x, y), samples_per_pixel, samplers, integrator,
-                          integrator_base);
+    evaluate_pixel_sample(film, Point2i(x, y), first_sample_idx, last_sample_idx, noise_threshold,
+                          samplers, integrator, integrator_base);
 
     if (gpu_frame_buffer == nullptr || counter == nullptr) {
         return;
@@ -155,6 +162,8 @@ SampledSpectrum MegakernelIntegrator::li(const Ray &ray, SampledWavelengths &lam
 
 void MegakernelIntegrator::render(Film *film, const std::string &sampler_type,
                                   const uint samples_per_pixel,
+                                  const std::pair<uint, uint> &sample_range,
+                                  const std::optional<FloatType> noise_threshold,
                                   const IntegratorBase *integrator_base, const bool preview) const {
     const auto film_resolution = integrator_base->camera->get_camerabase()->resolution;
     const auto num_pixels = film_resolution.x * film_resolution.y;
@@ -179,7 +188,9 @@ void MegakernelIntegrator::render(Film *film, const std::string &sampler_type,
                 divide_and_ceil(uint(film_resolution.y), thread_height), 1);
     dim3 threads(thread_width, thread_height, 1);
     megakernel_render<<<blocks, threads>>>(film, gl_helper.gpu_frame_buffer, counter,
-                                           samples_per_pixel, samplers, this, integrator_base);
+                                           sample_range.first, sample_range.second,
+                                           noise_threshold.value_or(0), samplers, this,
+                                           integrator_base);
 
     if (preview) {
         while (true) {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <optional>
 #include <pbrt/spectrum_util/sampled_spectrum.h>
 
 class Film;
@@ -50,7 +51,10 @@ class MegakernelIntegrator {
     PBRT_GPU
     SampledSpectrum li(const Ray &ray, SampledWavelengths &lambda, Sampler *sampler) const;
 
+    // with a noise_threshold, a pixel stops taking samples once its relative error falls below it
+    // only samples [sample_range.first, sample_range.second) of each pixel are rendered
     void render(Film *film, const std::string &sampler_type, uint samples_per_pixel,
+                const std::pair<uint, uint> &sample_range, std::optional<FloatType> noise_threshold,
                 const IntegratorBase *integrator_base, bool preview) const;
 
   private:
@@ -33,23 +33,7 @@ Shape::create(const std::string &type_of_shape, const Transform &render_from_obj
         auto file_path = parameters.root + "/" + parameters.get_one_string("filename");
         auto ply_mesh = TriQuadMesh::read_ply(file_path);
 
-        const Shape *shapes = nullptr;
-        uint num_shapes = 0;
-
-        if (!ply_mesh.triIndices.empty()) {
-            const auto result = TriangleMesh::build_triangles(
-                render_from_object, reverse_orientation, ply_mesh.p, ply_mesh.triIndices,
-                ply_mesh.n, ply_mesh.uv, allocator);
-            shapes = result.first;
-            num_shapes = result.second;
-        }
-
-        if (!ply_mesh.quadIndices.empty()) {
-            printf("\n%s(): Shape::plymesh.quadIndices not implemented\n", __func__);
-            REPORT_FATAL_ERROR();
-        }
-
-        return {shapes, num_shapes};
+        return create_ply_mesh(ply_mesh, render_from_object, reverse_orientation, allocator);
     }
 
     if (type_of_shape == "trianglemesh") {
@@ -67,11 +51,8 @@ Shape::create(const std::string &type_of_shape, const Transform &render_from_obj
         auto indices = parameters.get_integers("indices");
         auto points = parameters.get_point3_array("P");
 
-        const auto loop_subdivide_data = LoopSubdivide(levels, indices, points);
-
-        return TriangleMesh::build_triangles(
-            render_from_object, reverse_orientation, loop_subdivide_data.p_limit,
-            loop_subdivide_data.vertex_indices, loop_subdivide_data.normals, {}, allocator);
+        return create_loop_subdivision(levels, indices, points, render_from_object,
+                                       reverse_orientation, allocator);
     }
 
     printf("\nShape `%s` not implemented\n", type_of_shape.c_str());
@@ -80,6 +61,37 @@ Shape::create(const std::string &type_of_shape, const Transform &render_from_obj
     return {nullptr, 0};
 }
 
+std::pair<const Shape *, uint> Shape::create_ply_mesh(const TriQuadMesh &ply_mesh,
+                                                      const Transform &render_from_object,
+                                                      bool reverse_orientation,
+                                                      GPUMemoryAllocator &allocator) {
+    const Shape *shapes = nullptr;
+    uint num_shapes = 0;
+
+    if (!ply_mesh.triIndices.empty()) {
+        const auto result =
+            TriangleMesh::build_triangles(render_from_object, reverse_orientation, ply_mesh.p,
+                                          ply_mesh.triIndices, ply_mesh.n, ply_mesh.uv, allocator);
+        shapes = result.first;
+        num_shapes = result.second;
+    }
+
+    return {shapes, num_shapes};
+}
+
+std::pair<const Shape *, uint>
+Shape::create_loop_subdivision(int levels, const std::vector<int> &indices,
+                               const std::vector<Point3f> &points,
+                               const Transform &render_from_object, bool reverse_orientation,
+                               GPUMemoryAllocator &allocator) {
+    const auto loop_subdivide_data = LoopSubdivide(levels, indices, points);
+
+    return TriangleMesh::build_triangles(render_from_object, reverse_orientation,
+                                         loop_subdivide_data.p_limit,
+                                         loop_subdivide_data.vertex_indices,
+                                         loop_subdivide_data.normals, {}, allocator);
+}
+
 PBRT_CPU_GPU
 void Shape::init(const Disk *disk) {
     type = Type::disk;
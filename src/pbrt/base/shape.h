@@ -12,6 +12,7 @@ class Sphere;
 class Triangle;
 class Transform;
 class ParameterDictionary;
+struct TriQuadMesh;
 
 struct ShapeSampleContext {
     Point3fi pi;
@@ -83,6 +84,17 @@ class Shape {
            const Transform &object_from_render, bool reverse_orientation,
            const ParameterDictionary &parameters, GPUMemoryAllocator &allocator);
 
+    static std::pair<const Shape *, uint> create_ply_mesh(const TriQuadMesh &ply_mesh,
+                                                          const Transform &render_from_object,
+                                                          bool reverse_orientation,
+                                                          GPUMemoryAllocator &allocator);
+
+    static std::pair<const Shape *, uint>
+    create_loop_subdivision(int levels, const std::vector<int> &indices,
+                            const std::vector<Point3f> &points,
+                            const Transform &render_from_object, bool reverse_orientation,
+                            GPUMemoryAllocator &allocator);
+
     PBRT_CPU_GPU
     void init(const Disk *disk);
 
@@ -220,6 +220,23 @@ FloatType Spectrum::operator()(FloatType lambda) const {
     return NAN;
 }
 
+bool Spectrum::to_sigmoid_polynomial(FloatType &scale, RGBSigmoidPolynomial &rsp) const {
+    if (type == Type::rgb_albedo) {
+        scale = 1;
+        rsp = static_cast<const RGBAlbedoSpectrum *>(ptr)->get_rsp();
+        return true;
+    }
+
+    if (type == Type::rgb_unbounded) {
+        const auto unbounded_spectrum = static_cast<const RGBUnboundedSpectrum *>(ptr);
+        scale = unbounded_spectrum->get_scale();
+        rsp = unbounded_spectrum->get_rsp();
+        return true;
+    }
+
+    return false;
+}
+
 PBRT_CPU_GPU
 FloatType Spectrum::to_photometric(const Spectrum *cie_y) const {
     if (type == Type::rgb_illuminant) {
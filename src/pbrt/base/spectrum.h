@@ -1,5 +1,6 @@
 #pragma once
 
+#include <pbrt/spectrum_util/rgb_sigmoid_polynomial.h>
 #include <pbrt/spectrum_util/sampled_wavelengths.h>
 #include <pbrt/spectrum_util/xyz.h>
 
@@ -78,6 +79,9 @@ class Spectrum {
         return type == Type::constant;
     }
 
+    // writes the spectrum as `scale * rsp(lambda)` if it is RGB-derived (albedo or unbounded)
+    bool to_sigmoid_polynomial(FloatType &scale, RGBSigmoidPolynomial &rsp) const;
+
     PBRT_CPU_GPU FloatType operator()(FloatType lambda) const;
 
     PBRT_CPU_GPU
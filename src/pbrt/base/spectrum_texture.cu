@@ -77,6 +77,14 @@ void SpectrumTexture::init(const SpectrumCheckerboardTexture *checkerboard_textu
 void SpectrumTexture::init(const SpectrumConstantTexture *constant_texture) {
     type = Type::constant;
     ptr = constant_texture;
+
+    const auto spectrum = constant_texture->value;
+    if (spectrum->is_constant_spectrum()) {
+        type = Type::folded_constant;
+        folded_scale = (*spectrum)(LAMBDA_MIN);
+    } else if (spectrum->to_sigmoid_polynomial(folded_scale, folded_rsp)) {
+        type = Type::folded_rgb;
+    }
 }
 
 void SpectrumTexture::init(const SpectrumImageTexture *image_texture) {
@@ -101,6 +109,18 @@ SampledSpectrum SpectrumTexture::evaluate(const TextureEvalContext &ctx,
         return static_cast<const SpectrumConstantTexture *>(ptr)->evaluate(ctx, lambda);
     }
 
+    case Type::folded_constant: {
+        return SampledSpectrum(folded_scale);
+    }
+
+    case Type::folded_rgb: {
+        SampledSpectrum result;
+        for (int idx = 0; idx < NSpectrumSamples; ++idx) {
+            result[idx] = folded_scale * folded_rsp(lambda[idx]);
+        }
+        return result;
+    }
+
     case Type::image: {
         return static_cast<const SpectrumImageTexture *>(ptr)->evaluate(ctx, lambda);
     }
@@ -22,6 +22,8 @@ class SpectrumTexture {
     enum class Type {
         checkerboard,
         constant,
+        folded_constant,
+        folded_rgb,
         image,
         scaled,
     };
@@ -51,4 +53,9 @@ class SpectrumTexture {
   private:
     Type type;
     const void *ptr;
+
+    // constant textures are folded into the handle when built: evaluating them then skips
+    // both the texture and the spectrum dispatch
+    FloatType folded_scale;
+    RGBSigmoidPolynomial folded_rsp;
 };
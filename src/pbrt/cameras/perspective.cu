@@ -58,6 +58,8 @@ void PerspectiveCamera::init(const Point2i &resolution, const CameraTransform &c
     pMax /= pMax.z;
 
     A = std::abs((pMax.x - pMin.x) * (pMax.y - pMin.y));
+
+    camera_base.pixel_size_at_unit_distance = std::abs(pMax.x - pMin.x) / res.x;
 }
 
 PBRT_CPU_GPU
@@ -216,6 +216,10 @@ class Transform {
         return s.determinant() < 0;
     }
 
+    PBRT_CPU_GPU const SquareMatrix<4> &get_matrix() const {
+        return m;
+    }
+
     PBRT_CPU_GPU bool is_identity() const {
         if (m != inv_m) {
             return false;
@@ -19,6 +19,10 @@ class GreyScaleFilm {
 
     void write_to_png(const std::string &filename) const;
 
+    std::vector<FloatType> &get_pixels() {
+        return pixels;
+    }
+
   private:
     Point2i resolution;
     std::vector<FloatType> pixels;
@@ -1,6 +1,7 @@
 #include <pbrt/base/filter.h>
 #include <pbrt/films/pixel_sensor.h>
 #include <pbrt/films/rgb_film.h>
+#include <pbrt/films/unnormalized_film.h>
 #include <pbrt/scene/parameter_dictionary.h>
 #include <pbrt/spectrum_util/global_spectra.h>
 #include <pbrt/spectrum_util/rgb_color_space.h>
@@ -99,6 +100,36 @@ void RGBFilm::add_sample(uint pixel_index, const SampledSpectrum &radiance_l,
 
     pixels[pixel_index].rgb_sum += weight * rgb;
     pixels[pixel_index].weight_sum += weight;
+
+    auto &pixel = pixels[pixel_index];
+    const auto value = rgb.avg();
+    pixel.sample_count += 1;
+    const auto delta = value - pixel.sample_mean;
+    pixel.sample_mean += delta / pixel.sample_count;
+    pixel.sample_m2 += delta * (value - pixel.sample_mean);
+}
+
+PBRT_CPU_GPU
+FloatType RGBFilm::get_relative_error(const uint pixel_index) const {
+    const Pixel &pixel = pixels[pixel_index];
+    if (pixel.sample_count < 2) {
+        return Infinity;
+    }
+
+    const auto variance = pixel.sample_m2 / (pixel.sample_count - 1);
+    const auto standard_error = std::sqrt(variance / pixel.sample_count);
+
+    // a floor on the mean keeps (almost) black pixels from never converging
+    return standard_error / std::max<FloatType>(std::abs(pixel.sample_mean), 1e-3);
+}
+
+PBRT_CPU_GPU
+bool RGBFilm::is_converged(const uint pixel_index, const FloatType noise_threshold) const {
+    // too few samples give an unreliable variance estimate
+    constexpr uint min_samples = 16;
+
+    return pixels[pixel_index].sample_count >= min_samples &&
+           get_relative_error(pixel_index) <= noise_threshold;
 }
 
 void RGBFilm::add_splat(const Point2f &p_film, const SampledSpectrum &radiance_l,
@@ -142,3 +173,28 @@ RGB RGBFilm::get_pixel_rgb(const Point2i p, FloatType splat_scale) const {
 
     return output_rgb_from_sensor_rgb * rgb;
 }
+
+UnnormalizedFilm RGBFilm::to_unnormalized(const FloatType splat_spp) const {
+    UnnormalizedFilm film;
+    film.width = resolution.x;
+    film.height = resolution.y;
+    film.splat_spp = splat_spp;
+    film.filter_integral = filter_integral;
+
+    for (uint row = 0; row < 3; ++row) {
+        for (uint col = 0; col < 3; ++col) {
+            film.output_rgb_from_sensor_rgb[row * 3 + col] = output_rgb_from_sensor_rgb[row][col];
+        }
+    }
+
+    const auto num_pixels = resolution.x * resolution.y;
+    film.pixels.reserve(size_t(num_pixels) * UnnormalizedFilm::VALUES_PER_PIXEL);
+    for (uint idx = 0; idx < num_pixels; ++idx) {
+        const auto &pixel = pixels[idx];
+        film.pixels.insert(film.pixels.end(),
+                           {pixel.rgb_sum.r, pixel.rgb_sum.g, pixel.rgb_sum.b, pixel.weight_sum,
+                            pixel.rgb_splat.r, pixel.rgb_splat.g, pixel.rgb_splat.b});
+    }
+
+    return film;
+}
@@ -9,18 +9,28 @@ class GPUMemoryAllocator;
 class ParameterDictionary;
 class PixelSensor;
 class RGBColorSpace;
+struct UnnormalizedFilm;
 
 struct Pixel {
     RGB rgb_sum;
     FloatType weight_sum;
     RGB rgb_splat;
 
+    // running mean and variance (Welford) of each sample's average RGB
+    uint sample_count;
+    FloatType sample_mean;
+    FloatType sample_m2;
+
     PBRT_CPU_GPU
     void init_zero() {
         rgb_sum = RGB(0, 0, 0);
         weight_sum = 0;
 
         rgb_splat = RGB(0, 0, 0);
+
+        sample_count = 0;
+        sample_mean = 0;
+        sample_m2 = 0;
     }
 };
 
@@ -55,9 +65,22 @@ class RGBFilm {
     void add_splat(const Point2f &p_film, const SampledSpectrum &radiance_l,
                    const SampledWavelengths &lambda);
 
+    // standard error of the pixel's mean over the mean itself
+    PBRT_CPU_GPU
+    FloatType get_relative_error(uint pixel_index) const;
+
+    PBRT_CPU_GPU
+    bool is_converged(uint pixel_index, FloatType noise_threshold) const;
+
     PBRT_CPU_GPU
     RGB get_pixel_rgb(const Point2i p, FloatType splat_scale = 1) const;
 
+    Pixel *get_pixels() const {
+        return pixels;
+    }
+
+    UnnormalizedFilm to_unnormalized(FloatType splat_spp) const;
+
   private:
     Pixel *pixels;
     const PixelSensor *sensor;
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <ext/lodepng/lodepng.h>
+#include <pbrt/spectrum_util/color_encoding.h>
+#include <pbrt/util/checkpoint.h>
+#include <algorithm>
+#include <array>
+#include <vector>
+
+// the raw accumulators of a film, written by renders over a sample range (`--sample-range`) and
+// summed up by pbrt-merge: since each sample only depends on its (pixel, sample) index, merging
+// the films of disjoint ranges gives the same image as rendering all of them at once
+struct UnnormalizedFilm {
+    // per pixel: rgb_sum (3), weight_sum, rgb_splat (3)
+    static constexpr uint VALUES_PER_PIXEL = 7;
+
+    int width = 0;
+    int height = 0;
+
+    // samples per pixel of the complete render, and the `[first, last)` ranges of it accumulated
+    // in this film: a merge of overlapping ranges would count some samples twice
+    uint total_spp = 0;
+    std::vector<std::array<uint, 2>> sample_ranges;
+
+    // samples per pixel the splats were accumulated over
+    double splat_spp = 0;
+
+    // what the film needs to turn accumulated sensor RGB into output RGB
+    double output_rgb_from_sensor_rgb[9] = {0};
+    double filter_integral = 0;
+
+    std::vector<double> pixels;
+
+    void write(const std::string &filename) const {
+        CheckpointWriter writer(filename, TAG);
+        writer.write(width);
+        writer.write(height);
+        writer.write(total_spp);
+        writer.write(sample_ranges.size());
+        writer.write(sample_ranges.data(), sample_ranges.size());
+        writer.write(splat_spp);
+        writer.write(output_rgb_from_sensor_rgb, 9);
+        writer.write(filter_integral);
+        writer.write(pixels.data(), pixels.size());
+        writer.commit();
+    }
+
+    static UnnormalizedFilm read(const std::string &filename) {
+        CheckpointReader reader(filename, TAG);
+
+        UnnormalizedFilm film;
+        film.width = reader.read<int>();
+        film.height = reader.read<int>();
+        film.total_spp = reader.read<uint>();
+        film.sample_ranges = std::vector<std::array<uint, 2>>(reader.read<size_t>());
+        reader.read(film.sample_ranges.data(), film.sample_ranges.size());
+        film.splat_spp = reader.read<double>();
+        reader.read(film.output_rgb_from_sensor_rgb, 9);
+        film.filter_integral = reader.read<double>();
+
+        film.pixels = std::vector<double>(size_t(film.width) * film.height * VALUES_PER_PIXEL);
+        reader.read(film.pixels.data(), film.pixels.size());
+
+        return film;
+    }
+
+    void merge(const UnnormalizedFilm &other) {
+        if (width != other.width || height != other.height) {
+            printf("\n%s(): resolution mismatch: %dx%d vs %dx%d\n", __func__, width, height,
+                   other.width, other.height);
+            REPORT_FATAL_ERROR();
+        }
+
+        if (total_spp != other.total_spp) {
+            printf("\n%s(): films rendered with %u and %u samples per pixel\n", __func__,
+                   total_spp, other.total_spp);
+            REPORT_FATAL_ERROR();
+        }
+
+        // films of the same scene carry bit-identical filter and color conversion
+        if (filter_integral != other.filter_integral ||
+            !std::equal(std::begin(output_rgb_from_sensor_rgb), std::end(output_rgb_from_sensor_rgb),
+                        std::begin(other.output_rgb_from_sensor_rgb))) {
+            printf("\n%s(): films rendered with different filters or color spaces\n", __func__);
+            REPORT_FATAL_ERROR();
+        }
+
+        for (const auto &range : sample_ranges) {
+            for (const auto &other_range : other.sample_ranges) {
+                if (range[0] < other_range[1] && other_range[0] < range[1]) {
+                    printf("\n%s(): sample ranges %u:%u and %u:%u overlap\n", __func__, range[0],
+                           range[1], other_range[0], other_range[1]);
+                    REPORT_FATAL_ERROR();
+                }
+            }
+        }
+        sample_ranges.insert(sample_ranges.end(), other.sample_ranges.begin(),
+                             other.sample_ranges.end());
+
+        splat_spp += other.splat_spp;
+        for (size_t idx = 0; idx < pixels.size(); ++idx) {
+            pixels[idx] += other.pixels[idx];
+        }
+    }
+
+    uint count_samples() const {
+        uint num = 0;
+        for (const auto &range : sample_ranges) {
+            num += range[1] - range[0];
+        }
+
+        return num;
+    }
+
+    void write_to_png(const std::string &filename) const {
+        const SRGBColorEncoding srgb_encoding;
+        std::vector<unsigned char> png_pixels(size_t(width) * height * 4);
+
+        const double splat_scale = splat_spp > 0 ? 1.0 / (splat_spp * filter_integral) : 0;
+
+        for (size_t pixel_idx = 0; pixel_idx < size_t(width) * height; ++pixel_idx) {
+            const double *values = &pixels[pixel_idx * VALUES_PER_PIXEL];
+            const double weight_sum = values[3];
+
+            double sensor_rgb[3];
+            for (uint c = 0; c < 3; ++c) {
+                sensor_rgb[c] = (weight_sum != 0 ? values[c] / weight_sum : values[c]) +
+                                values[4 + c] * splat_scale;
+            }
+
+            for (uint c = 0; c < 3; ++c) {
+                const double rgb = output_rgb_from_sensor_rgb[c * 3 + 0] * sensor_rgb[0] +
+                                   output_rgb_from_sensor_rgb[c * 3 + 1] * sensor_rgb[1] +
+                                   output_rgb_from_sensor_rgb[c * 3 + 2] * sensor_rgb[2];
+                png_pixels[4 * pixel_idx + c] = srgb_encoding.from_linear(rgb);
+            }
+            png_pixels[4 * pixel_idx + 3] = 255;
+        }
+
+        if (unsigned error = lodepng::encode(filename, png_pixels, width, height); error) {
+            std::cerr << "lodepng::encoder error " << error << ": " << lodepng_error_text(error)
+                      << std::endl;
+            throw std::runtime_error("lodepng::encode() fail");
+        }
+    }
+
+  private:
+    static constexpr char TAG[] = "unnormalized film";
+};
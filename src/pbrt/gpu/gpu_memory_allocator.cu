@@ -1,7 +1,105 @@
+#include <array>
+#include <fstream>
 #include <iomanip>
+#include <mutex>
 #include <pbrt/gpu/gpu_memory_allocator.h>
 #include <pbrt/util/math.h>
 
+namespace {
+constexpr uint NUM_CATEGORIES = static_cast<uint>(MemoryCategory::NUM_CATEGORIES);
+
+struct MemoryUsage {
+    size_t current = 0;
+    size_t peak = 0;
+};
+
+std::mutex memory_usage_mutex;
+std::array<MemoryUsage, NUM_CATEGORIES> category_usage;
+MemoryUsage total_usage;
+
+// a Scope only tags allocations of the thread that opened it
+thread_local MemoryCategory active_category = MemoryCategory::Unclassified;
+
+const char *category_name(const MemoryCategory category) {
+    switch (category) {
+    case MemoryCategory::Unclassified: {
+        return "unclassified";
+    }
+    case MemoryCategory::BVH: {
+        return "bvh";
+    }
+    case MemoryCategory::MortonPrimitives: {
+        return "morton-primitives";
+    }
+    case MemoryCategory::Mesh: {
+        return "mesh";
+    }
+    case MemoryCategory::Texture: {
+        return "texture";
+    }
+    case MemoryCategory::Spectrum: {
+        return "spectrum";
+    }
+    case MemoryCategory::Material: {
+        return "material";
+    }
+    case MemoryCategory::Light: {
+        return "light";
+    }
+    case MemoryCategory::PathState: {
+        return "path-state";
+    }
+    case MemoryCategory::Film: {
+        return "film";
+    }
+    case MemoryCategory::Sampler: {
+        return "sampler";
+    }
+    default: {
+        REPORT_FATAL_ERROR();
+        return nullptr;
+    }
+    }
+}
+
+std::string format_size(const size_t size) {
+    std::stringstream stream;
+    stream << std::fixed << std::setprecision(1) << (FloatType(size) / (1024 * 1024)) << " MB";
+    return stream.str();
+}
+} // namespace
+
+GPUMemoryAllocator::Scope::Scope(const MemoryCategory category)
+    : previous_category(active_category) {
+    active_category = category;
+}
+
+GPUMemoryAllocator::Scope::~Scope() {
+    active_category = previous_category;
+}
+
+MemoryCategory GPUMemoryAllocator::get_active_category() {
+    return active_category;
+}
+
+void GPUMemoryAllocator::record_allocation(const MemoryCategory category, const size_t size) {
+    std::lock_guard lock(memory_usage_mutex);
+
+    auto &usage = category_usage[static_cast<uint>(category)];
+    usage.current += size;
+    usage.peak = std::max(usage.peak, usage.current);
+
+    total_usage.current += size;
+    total_usage.peak = std::max(total_usage.peak, total_usage.current);
+}
+
+void GPUMemoryAllocator::record_release(const MemoryCategory category, const size_t size) {
+    std::lock_guard lock(memory_usage_mutex);
+
+    category_usage[static_cast<uint>(category)].current -= size;
+    total_usage.current -= size;
+}
+
 std::string GPUMemoryAllocator::get_allocated_memory_size() const {
     const auto size_in_mb = divide_and_ceil<ulong>(allocated_memory_size, 1024 * 1024);
 
@@ -13,3 +111,41 @@ std::string GPUMemoryAllocator::get_allocated_memory_size() const {
     stream << std::fixed << std::setprecision(1) << (FloatType(size_in_mb) / 1024);
     return stream.str() + " GB";
 }
+
+void GPUMemoryAllocator::print_memory_usage() {
+    std::lock_guard lock(memory_usage_mutex);
+
+    printf("GPU memory (current / peak):\n");
+    for (uint idx = 0; idx < NUM_CATEGORIES; ++idx) {
+        const auto &usage = category_usage[idx];
+        if (usage.peak == 0) {
+            continue;
+        }
+
+        printf("    %s: %s / %s\n", category_name(static_cast<MemoryCategory>(idx)),
+               format_size(usage.current).c_str(), format_size(usage.peak).c_str());
+    }
+    printf("    total: %s / %s\n", format_size(total_usage.current).c_str(),
+           format_size(total_usage.peak).c_str());
+    printf("\n");
+}
+
+void GPUMemoryAllocator::write_memory_usage_json(const std::string &filename) {
+    std::lock_guard lock(memory_usage_mutex);
+
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        printf("\n%s(): fail to open `%s`\n", __func__, filename.c_str());
+        REPORT_FATAL_ERROR();
+    }
+
+    file << "{\n";
+    for (uint idx = 0; idx < NUM_CATEGORIES; ++idx) {
+        const auto &usage = category_usage[idx];
+        file << "  \"" << category_name(static_cast<MemoryCategory>(idx))
+             << "\": {\"current\": " << usage.current << ", \"peak\": " << usage.peak << "},\n";
+    }
+    file << "  \"total\": {\"current\": " << total_usage.current
+         << ", \"peak\": " << total_usage.peak << "}\n";
+    file << "}\n";
+}
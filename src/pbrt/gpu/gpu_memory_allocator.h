@@ -1,13 +1,46 @@
 #pragma once
 
 #include <pbrt/gpu/macro.h>
+#include <string>
 #include <vector>
 
+enum class MemoryCategory {
+    Unclassified,
+    BVH,
+    MortonPrimitives,
+    Mesh,
+    Texture,
+    Spectrum,
+    Material,
+    Light,
+    PathState,
+    Film,
+    Sampler,
+    NUM_CATEGORIES,
+};
+
 class GPUMemoryAllocator {
   public:
+    // allocations (from any allocator) made on the same thread while a Scope is alive are
+    // accounted under its category, the innermost Scope wins
+    class Scope {
+      public:
+        explicit Scope(MemoryCategory category);
+
+        ~Scope();
+
+        Scope(const Scope &) = delete;
+
+        Scope &operator=(const Scope &) = delete;
+
+      private:
+        MemoryCategory previous_category;
+    };
+
     ~GPUMemoryAllocator() {
-        for (auto ptr : gpu_dynamic_pointers) {
-            CHECK_CUDA_ERROR(cudaFree(ptr));
+        for (const auto &allocation : gpu_dynamic_allocations) {
+            CHECK_CUDA_ERROR(cudaFree(allocation.ptr));
+            record_release(allocation.category, allocation.size);
         }
         CHECK_CUDA_ERROR(cudaGetLastError());
     }
@@ -18,7 +51,10 @@ class GPUMemoryAllocator {
 
         const auto size = sizeof(T) * num;
         CHECK_CUDA_ERROR(cudaMallocManaged(&data, size));
-        gpu_dynamic_pointers.push_back(data);
+
+        const auto category = get_active_category();
+        gpu_dynamic_allocations.push_back({data, size, category});
+        record_allocation(category, size);
 
         allocated_memory_size += size;
 
@@ -27,7 +63,24 @@ class GPUMemoryAllocator {
 
     [[nodiscard]] std::string get_allocated_memory_size() const;
 
+    // current and peak bytes per category, summed over every live allocator
+    static void print_memory_usage();
+
+    static void write_memory_usage_json(const std::string &filename);
+
   private:
-    std::vector<void *> gpu_dynamic_pointers;
+    struct Allocation {
+        void *ptr;
+        size_t size;
+        MemoryCategory category;
+    };
+
+    std::vector<Allocation> gpu_dynamic_allocations;
     ulong allocated_memory_size = 0;
+
+    static MemoryCategory get_active_category();
+
+    static void record_allocation(MemoryCategory category, size_t size);
+
+    static void record_release(MemoryCategory category, size_t size);
 };
@@ -1,9 +1,11 @@
+#include <chrono>
 #include <pbrt/accelerator/hlbvh.h>
 #include <pbrt/base/film.h>
 #include <pbrt/base/integrator_base.h>
 #include <pbrt/base/interaction.h>
 #include <pbrt/base/material.h>
 #include <pbrt/base/sampler.h>
+#include <pbrt/films/rgb_film.h>
 #include <pbrt/gpu/gpu_memory_allocator.h>
 #include <pbrt/gui/gl_helper.h>
 #include <pbrt/integrators/bdpt.h>
@@ -12,6 +14,7 @@
 #include <pbrt/samplers/independent.h>
 #include <pbrt/samplers/stratified.h>
 #include <pbrt/scene/parameter_dictionary.h>
+#include <pbrt/util/checkpoint.h>
 
 constexpr size_t NUM_SAMPLERS = 64 * 1024;
 
@@ -914,6 +917,8 @@ BDPTIntegrator *BDPTIntegrator::create(int samples_per_pixel, const std::string
                                        const IntegratorBase *integrator_base,
                                        GPUMemoryAllocator &allocator) {
     auto bdpt_integrator = allocator.allocate<BDPTIntegrator>();
+
+    GPUMemoryAllocator::Scope memory_scope(MemoryCategory::Sampler);
     auto samplers = allocator.allocate<Sampler>(NUM_SAMPLERS);
 
     bdpt_integrator->samplers = samplers;
@@ -949,7 +954,8 @@ BDPTIntegrator *BDPTIntegrator::create(int samples_per_pixel, const std::string
 
 __global__ void wavefront_render(BDPTSample *bdpt_samples, FilmSample *film_samples,
                                  int *film_sample_counter, Vertex *global_camera_vertices,
-                                 Vertex *global_light_vertices, uint pass, uint samples_per_pixel,
+                                 Vertex *global_light_vertices, uint pass,
+                                 const uint first_sample_idx, const uint last_sample_idx,
                                  const Point2i film_resolution, BDPTIntegrator *bdpt_integrator) {
     const uint worker_idx = blockIdx.x * blockDim.x + threadIdx.x;
     if (worker_idx >= NUM_SAMPLERS) {
@@ -959,11 +965,12 @@ __global__ void wavefront_render(BDPTSample *bdpt_samples, FilmSample *film_samp
     const auto width = film_resolution.x;
     const auto height = film_resolution.y;
 
-    auto global_idx = (long long)(pass)*NUM_SAMPLERS + worker_idx;
+    auto global_idx = (long long)(first_sample_idx)*width * height +
+                      (long long)(pass)*NUM_SAMPLERS + worker_idx;
 
     const auto pixel_idx = global_idx % (width * height);
     const auto sample_idx = global_idx / (width * height);
-    if (sample_idx >= samples_per_pixel) {
+    if (sample_idx >= last_sample_idx) {
         return;
     }
 
@@ -996,10 +1003,15 @@ __global__ void wavefront_render(BDPTSample *bdpt_samples, FilmSample *film_samp
     rendered_sample->lambda = lambda;
 }
 
-void BDPTIntegrator::render(Film *film, uint samples_per_pixel, const bool preview) {
+FloatType BDPTIntegrator::render(Film *film, uint samples_per_pixel,
+                                 const std::pair<uint, uint> &sample_range,
+                                 const std::optional<FloatType> time_limit,
+                                 const CheckpointOption &checkpoint_option, const bool preview) {
+    const auto start = std::chrono::system_clock::now();
     const auto image_resolution = film->get_resolution();
 
     GPUMemoryAllocator local_allocator;
+    GPUMemoryAllocator::Scope memory_scope(MemoryCategory::PathState);
 
     GLHelper gl_helper;
     if (preview) {
@@ -1020,22 +1032,67 @@ void BDPTIntegrator::render(Film *film, uint samples_per_pixel, const bool previ
     constexpr uint threads = 32;
     const uint blocks = divide_and_ceil<uint>(NUM_SAMPLERS, threads);
 
-    auto total_pass = divide_and_ceil<long long>(num_pixels * samples_per_pixel, NUM_SAMPLERS);
+    const auto [first_sample_idx, last_sample_idx] = sample_range;
+    auto total_pass = divide_and_ceil<long long>(
+        (long long)(num_pixels) * (last_sample_idx - first_sample_idx), NUM_SAMPLERS);
+
+    // samplers are seeded again for every sample, so the film and the pass index are all the
+    // state there is
+    const std::string checkpoint_tag = "bdpt " + std::to_string(image_resolution.x) + "x" +
+                                       std::to_string(image_resolution.y) + " spp " +
+                                       std::to_string(samples_per_pixel) + " range " +
+                                       std::to_string(first_sample_idx) + ":" +
+                                       std::to_string(last_sample_idx) + " scene " +
+                                       std::to_string(checkpoint_option.render_hash);
+
+    uint start_pass = 0;
+    long long rendered_samples = 0;
+    if (checkpoint_option.resume_file.has_value()) {
+        CheckpointReader reader(checkpoint_option.resume_file.value(), checkpoint_tag);
+        start_pass = reader.read<uint>();
+        rendered_samples = reader.read<long long>();
+        reader.read(film->get_pixels(), num_pixels);
+
+        printf("BDPT: resumed from `%s` at pass %u/%lld\n",
+               checkpoint_option.resume_file->c_str(), start_pass, total_pass);
+    }
+
+    const auto write_checkpoint = [&](const uint next_pass) {
+        CheckpointWriter writer(checkpoint_option.checkpoint_file.value(), checkpoint_tag);
+        writer.write(next_pass);
+        writer.write(rendered_samples);
+        writer.write(film->get_pixels(), num_pixels);
+        writer.commit();
+    };
+
+    auto last_checkpoint = std::chrono::system_clock::now();
+    for (uint pass = start_pass; pass < total_pass; ++pass) {
+        if (time_limit.has_value() &&
+            std::chrono::duration<FloatType>(std::chrono::system_clock::now() - start).count() >=
+                time_limit.value()) {
+            printf("BDPT: time limit reached after %u/%lld passes\n", pass, total_pass);
+            if (checkpoint_option.checkpoint_file.has_value()) {
+                write_checkpoint(pass);
+            }
+            break;
+        }
 
-    for (uint pass = 0; pass < total_pass; ++pass) {
         *film_sample_counter = 0;
         wavefront_render<<<blocks, threads>>>(bdpt_samples, film_samples, film_sample_counter,
                                               global_camera_vertices, global_light_vertices, pass,
-                                              samples_per_pixel, film->get_resolution(), this);
+                                              first_sample_idx, last_sample_idx,
+                                              film->get_resolution(), this);
         CHECK_CUDA_ERROR(cudaDeviceSynchronize());
 
         for (uint idx = 0; idx < NUM_SAMPLERS; ++idx) {
-            const auto global_idx = (long long)(pass)*NUM_SAMPLERS + idx;
+            const auto global_idx = (long long)(first_sample_idx)*num_pixels +
+                                    (long long)(pass)*NUM_SAMPLERS + idx;
             const auto sample_idx = global_idx / num_pixels;
-            if (sample_idx >= samples_per_pixel) {
-                return;
+            if (sample_idx >= last_sample_idx) {
+                break;
             }
 
+            rendered_samples += 1;
             const auto sample = &bdpt_samples[idx];
             film->add_sample(sample->p_pixel, sample->l_path, sample->lambda, sample->weight);
         }
@@ -1051,10 +1108,20 @@ void BDPTIntegrator::render(Film *film, uint samples_per_pixel, const bool previ
         }
 
         if (preview) {
-            film->copy_to_frame_buffer(gl_helper.gpu_frame_buffer, 1.0 / samples_per_pixel);
+            film->copy_to_frame_buffer(gl_helper.gpu_frame_buffer,
+                                       FloatType(num_pixels) / std::max(rendered_samples, 1ll));
             gl_helper.draw_frame(GLHelper::assemble_title(FloatType(pass + 1) / total_pass));
         }
+
+        if (checkpoint_option.checkpoint_file.has_value() &&
+            std::chrono::duration<FloatType>(std::chrono::system_clock::now() - last_checkpoint)
+                    .count() >= checkpoint_option.interval) {
+            write_checkpoint(pass + 1);
+            last_checkpoint = std::chrono::system_clock::now();
+        }
     }
+
+    return rendered_samples > 0 ? FloatType(num_pixels) / rendered_samples : 0;
 }
 
 PBRT_GPU
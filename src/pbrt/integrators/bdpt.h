@@ -1,8 +1,10 @@
 #pragma once
 
+#include <optional>
 #include <pbrt/gpu/macro.h>
 
 class GPUMemoryAllocator;
+struct CheckpointOption;
 class ParameterDictionary;
 class Ray;
 class SampledSpectrum;
@@ -20,7 +22,11 @@ class BDPTIntegrator {
                                   const IntegratorBase *integrator_base,
                                   GPUMemoryAllocator &allocator);
 
-    void render(Film *film, uint samples_per_pixel, bool preview);
+    // stops starting new passes once time_limit (in seconds) is up,
+    // returns the scale for splats over the samples actually rendered
+    FloatType render(Film *film, uint samples_per_pixel, const std::pair<uint, uint> &sample_range,
+                     std::optional<FloatType> time_limit,
+                     const CheckpointOption &checkpoint_option, bool preview);
 
     PBRT_GPU
     SampledSpectrum li(FilmSample *film_samples, int *film_sample_counter, const Ray &ray,
@@ -1,9 +1,11 @@
+#include <chrono>
 #include <numeric>
 #include <pbrt/base/camera.h>
 #include <pbrt/base/film.h>
 #include <pbrt/base/integrator_base.h>
 #include <pbrt/base/sampler.h>
 #include <pbrt/films/grey_scale_film.h>
+#include <pbrt/films/rgb_film.h>
 #include <pbrt/gpu/gpu_memory_allocator.h>
 #include <pbrt/gui/gl_helper.h>
 #include <pbrt/integrators/megakernel_path.h>
@@ -11,6 +13,7 @@
 #include <pbrt/samplers/mlt.h>
 #include <pbrt/scene/parameter_dictionary.h>
 #include <pbrt/spectrum_util/global_spectra.h>
+#include <pbrt/util/checkpoint.h>
 
 constexpr size_t NUM_MLT_SAMPLERS = 64 * 1024;
 // large number of samplers: large number of shallow markov chains
@@ -150,8 +153,11 @@ MLTPathIntegrator *MLTPathIntegrator::create(const int mutations_per_pixel,
     auto integrator = allocator.allocate<MLTPathIntegrator>();
 
     integrator->base = base;
-    integrator->mlt_samplers = allocator.allocate<MLTSampler>(NUM_MLT_SAMPLERS);
-    integrator->samplers = allocator.allocate<Sampler>(NUM_MLT_SAMPLERS);
+    {
+        GPUMemoryAllocator::Scope memory_scope(MemoryCategory::Sampler);
+        integrator->mlt_samplers = allocator.allocate<MLTSampler>(NUM_MLT_SAMPLERS);
+        integrator->samplers = allocator.allocate<Sampler>(NUM_MLT_SAMPLERS);
+    }
 
     const auto large_step_probability = parameters.get_float("largestepprobability", 0.3);
     const auto sigma = parameters.get_float("sigma", 0.01);
@@ -191,9 +197,13 @@ PathSample MLTPathIntegrator::generate_path_sample(Sampler *sampler) const {
 }
 
 double MLTPathIntegrator::render(Film *film, GreyScaleFilm &heat_map,
-                                 const uint mutations_per_pixel, const bool preview) {
+                                 const uint mutations_per_pixel,
+                                 const std::optional<FloatType> time_limit,
+                                 const CheckpointOption &checkpoint_option, const bool preview) {
+    const auto start = std::chrono::system_clock::now();
     const auto image_resolution = film->get_resolution();
     GPUMemoryAllocator local_allocator;
+    GPUMemoryAllocator::Scope memory_scope(MemoryCategory::PathState);
 
     const auto num_paths_per_worker =
         divide_and_ceil<int>(film_dimension.x * film_dimension.y, NUM_MLT_SAMPLERS);
@@ -205,18 +215,54 @@ double MLTPathIntegrator::render(Film *film, GreyScaleFilm &heat_map,
     }
 
     auto path_samples = local_allocator.allocate<PathSample>(NUM_MLT_SAMPLERS);
-    auto luminance_per_path = local_allocator.allocate<double>(num_bootstrap_paths);
+    auto rngs = local_allocator.allocate<RNG>(NUM_MLT_SAMPLERS);
 
     constexpr uint threads = 64;
     const uint blocks = divide_and_ceil<uint>(NUM_MLT_SAMPLERS, threads);
-    build_bootstrap_samples<<<blocks, threads>>>(num_paths_per_worker, luminance_per_path, this);
-    CHECK_CUDA_ERROR(cudaGetLastError());
-    CHECK_CUDA_ERROR(cudaDeviceSynchronize());
 
-    const double sum_luminance =
-        std::accumulate(luminance_per_path + 0, luminance_per_path + num_bootstrap_paths, 0.0);
+    // the markov chains (samplers, current paths and RNGs) are saved along with the film and the
+    // heat map, resuming skips bootstrapping
+    const std::string checkpoint_tag = "mlt " + std::to_string(image_resolution.x) + "x" +
+                                       std::to_string(image_resolution.y) + " mutations " +
+                                       std::to_string(mutations_per_pixel) + " scene " +
+                                       std::to_string(checkpoint_option.render_hash);
+    const auto num_pixels = image_resolution.x * image_resolution.y;
+
+    uint start_pass = 0;
+    long long accumulate_samples = 0; // this is for debugging and verification
+    double brightness = 0;
+
+    if (checkpoint_option.resume_file.has_value()) {
+        CheckpointReader reader(checkpoint_option.resume_file.value(), checkpoint_tag);
+        start_pass = reader.read<uint>();
+        accumulate_samples = reader.read<long long>();
+        brightness = reader.read<double>();
+        reader.read(mlt_samplers, NUM_MLT_SAMPLERS);
+        reader.read(path_samples, NUM_MLT_SAMPLERS);
+        reader.read(rngs, NUM_MLT_SAMPLERS);
+        reader.read(film->get_pixels(), num_pixels);
+        reader.read(heat_map.get_pixels().data(), num_pixels);
+    } else {
+        auto luminance_per_path = local_allocator.allocate<double>(num_bootstrap_paths);
+
+        build_bootstrap_samples<<<blocks, threads>>>(num_paths_per_worker, luminance_per_path,
+                                                     this);
+        CHECK_CUDA_ERROR(cudaGetLastError());
+        CHECK_CUDA_ERROR(cudaDeviceSynchronize());
+
+        const double sum_luminance =
+            std::accumulate(luminance_per_path + 0, luminance_per_path + num_bootstrap_paths, 0.0);
+
+        brightness = sum_luminance / num_bootstrap_paths;
+
+        for (uint idx = 0; idx < NUM_MLT_SAMPLERS; ++idx) {
+            rngs[idx].set_sequence(idx + NUM_MLT_SAMPLERS);
+        }
 
-    const double brightness = sum_luminance / num_bootstrap_paths;
+        select_initial_state<<<blocks, threads>>>(path_samples, this);
+        CHECK_CUDA_ERROR(cudaGetLastError());
+        CHECK_CUDA_ERROR(cudaDeviceSynchronize());
+    }
 
     const long long total_mutations =
         static_cast<long long>(mutations_per_pixel) * film_dimension.x * film_dimension.y;
@@ -240,18 +286,38 @@ double MLTPathIntegrator::render(Film *film, GreyScaleFilm &heat_map,
         gl_helper.init("initializing", image_resolution);
     }
 
-    auto rngs = local_allocator.allocate<RNG>(NUM_MLT_SAMPLERS);
-
-    for (uint idx = 0; idx < NUM_MLT_SAMPLERS; ++idx) {
-        rngs[idx].set_sequence(idx + NUM_MLT_SAMPLERS);
+    if (checkpoint_option.resume_file.has_value()) {
+        printf("MLT-PATH: resumed from `%s` at pass %u/%lld\n",
+               checkpoint_option.resume_file->c_str(), start_pass, total_pass);
     }
 
-    select_initial_state<<<blocks, threads>>>(path_samples, this);
-    CHECK_CUDA_ERROR(cudaGetLastError());
-    CHECK_CUDA_ERROR(cudaDeviceSynchronize());
+    const auto write_checkpoint = [&](const uint next_pass) {
+        CheckpointWriter writer(checkpoint_option.checkpoint_file.value(), checkpoint_tag);
+        writer.write(next_pass);
+        writer.write(accumulate_samples);
+        writer.write(brightness);
+        writer.write(mlt_samplers, NUM_MLT_SAMPLERS);
+        writer.write(path_samples, NUM_MLT_SAMPLERS);
+        writer.write(rngs, NUM_MLT_SAMPLERS);
+        writer.write(film->get_pixels(), num_pixels);
+        writer.write(heat_map.get_pixels().data(), num_pixels);
+        writer.commit();
+    };
+
+    bool time_limit_reached = false;
+    auto last_checkpoint = std::chrono::system_clock::now();
+    for (uint pass = start_pass; pass < total_pass; ++pass) {
+        if (time_limit.has_value() &&
+            std::chrono::duration<FloatType>(std::chrono::system_clock::now() - start).count() >=
+                time_limit.value()) {
+            printf("MLT-PATH: time limit reached after %u/%lld passes\n", pass, total_pass);
+            if (checkpoint_option.checkpoint_file.has_value()) {
+                write_checkpoint(pass);
+            }
+            time_limit_reached = true;
+            break;
+        }
 
-    long long accumulate_samples = 0; // this is for debugging and verification
-    for (uint pass = 0; pass < total_pass; ++pass) {
         const uint num_mutations = pass == total_pass - 1
                                        ? total_mutations - (total_pass - 1) * NUM_MLT_SAMPLERS
                                        : NUM_MLT_SAMPLERS;
@@ -283,11 +349,21 @@ double MLTPathIntegrator::render(Film *film, GreyScaleFilm &heat_map,
                                        brightness / mutations_per_pixel);
             gl_helper.draw_frame(GLHelper::assemble_title(FloatType(pass + 1) / total_pass));
         }
+
+        if (checkpoint_option.checkpoint_file.has_value() &&
+            std::chrono::duration<FloatType>(std::chrono::system_clock::now() - last_checkpoint)
+                    .count() >= checkpoint_option.interval) {
+            write_checkpoint(pass + 1);
+            last_checkpoint = std::chrono::system_clock::now();
+        }
     }
 
-    if (accumulate_samples != total_mutations * 2) {
+    if (!time_limit_reached && accumulate_samples != total_mutations * 2) {
         REPORT_FATAL_ERROR();
     }
 
-    return brightness;
+    // each mutation contributes 2 samples (the proposed and the current state)
+    const auto rendered_mutations = accumulate_samples / 2;
+
+    return rendered_mutations > 0 ? brightness * num_pixels / rendered_mutations : 0.0;
 }
@@ -1,11 +1,13 @@
 #pragma once
 
+#include <optional>
 #include <pbrt/gpu/macro.h>
 #include <pbrt/spectrum_util/sampled_spectrum.h>
 
 class Film;
 class GreyScaleFilm;
 class GPUMemoryAllocator;
+struct CheckpointOption;
 class MLTSampler;
 class ParameterDictionary;
 class Spectrum;
@@ -28,7 +30,11 @@ class MLTPathIntegrator {
                                      const ParameterDictionary &parameters,
                                      const IntegratorBase *base, GPUMemoryAllocator &allocator);
 
-    double render(Film *film, GreyScaleFilm &heat_map, uint mutations_per_pixel, bool preview);
+    // stops starting new passes once time_limit (in seconds) is up,
+    // returns the scale for splats over the mutations actually rendered
+    double render(Film *film, GreyScaleFilm &heat_map, uint mutations_per_pixel,
+                  std::optional<FloatType> time_limit, const CheckpointOption &checkpoint_option,
+                  bool preview);
 
     PBRT_CPU_GPU
     FloatType compute_luminance(const SampledSpectrum &radiance,
@@ -1,9 +1,12 @@
+#include <chrono>
+#include <cub/device/device_radix_sort.cuh>
 #include <pbrt/accelerator/hlbvh.h>
 #include <pbrt/base/film.h>
 #include <pbrt/base/integrator_base.h>
 #include <pbrt/base/light.h>
 #include <pbrt/base/material.h>
 #include <pbrt/base/sampler.h>
+#include <pbrt/films/rgb_film.h>
 #include <pbrt/gpu/gpu_memory_allocator.h>
 #include <pbrt/gui/gl_helper.h>
 #include <pbrt/integrators/wavefront_path.h>
@@ -13,31 +16,111 @@
 #include <pbrt/scene/parameter_dictionary.h>
 #include <pbrt/spectrum_util/sampled_spectrum.h>
 #include <pbrt/spectrum_util/sampled_wavelengths.h>
+#include <pbrt/textures/texture_pool.h>
+#include <pbrt/util/checkpoint.h>
 #include <pbrt/util/math.h>
 
-constexpr uint PATH_POOL_SIZE = 2 * 1024 * 1024;
-
 struct FrameBuffer {
     uint pixel_idx;
     uint sample_idx;
     SampledSpectrum radiance;
     SampledWavelengths lambda;
     FloatType weight;
+};
+
+// what ray_cast keeps of a hit until the path is shaded, the SurfaceInteraction is rebuilt from
+// it in gpu_evaluate_material: differentials are recomputed there anyway, t_hit and the normal
+// derivatives (unused by every material) are dropped
+struct SurfaceRecord {
+    Point3fi pi;
+    Normal3f n;
+    Point2f uv;
+    Vector3f dpdu;
+    Vector3f dpdv;
+
+    Normal3f shading_n;
+    Vector3f shading_dpdu;
+    Vector3f shading_dpdv;
+
+    int face_index;
 
-    // to help sorting
-    bool operator<(const FrameBuffer &right) const {
-        if (pixel_idx < right.pixel_idx) {
-            return true;
+    // nullptr when the ray left the scene
+    const Material *material;
+    const Light *area_light;
+
+    PBRT_CPU_GPU
+    void init(const pbrt::optional<ShapeIntersection> &shape_intersection) {
+        if (!shape_intersection.has_value()) {
+            material = nullptr;
+            area_light = nullptr;
+            return;
         }
 
-        if (pixel_idx > right.pixel_idx) {
-            return false;
+        const auto &isect = shape_intersection->interaction;
+        pi = isect.pi;
+        n = isect.n;
+        uv = isect.uv;
+        dpdu = isect.dpdu;
+        dpdv = isect.dpdv;
+
+        shading_n = isect.shading.n;
+        shading_dpdu = isect.shading.dpdu;
+        shading_dpdv = isect.shading.dpdv;
+
+        face_index = isect.faceIndex;
+
+        material = isect.material;
+        area_light = isect.area_light;
+    }
+
+    PBRT_CPU_GPU
+    bool has_value() const {
+        return material != nullptr;
+    }
+
+    PBRT_CPU_GPU
+    SampledSpectrum le(const Vector3f &w, const SampledWavelengths &lambda) const {
+        if (area_light == nullptr) {
+            return SampledSpectrum(0.0);
         }
 
-        return sample_idx < right.sample_idx;
+        return area_light->l(pi.to_point3f(), n, uv, w, lambda);
+    }
+
+    PBRT_CPU_GPU
+    SurfaceInteraction to_surface_interaction(const Vector3f &wo) const {
+        SurfaceInteraction isect;
+        isect.pi = pi;
+        isect.n = n;
+        isect.uv = uv;
+        isect.wo = wo.normalize();
+        isect.dpdu = dpdu;
+        isect.dpdv = dpdv;
+        isect.dndu = Normal3f(0, 0, 0);
+        isect.dndv = Normal3f(0, 0, 0);
+
+        isect.shading.n = shading_n;
+        isect.shading.dpdu = shading_dpdu;
+        isect.shading.dpdv = shading_dpdv;
+        isect.shading.dndu = Normal3f(0, 0, 0);
+        isect.shading.dndv = Normal3f(0, 0, 0);
+
+        isect.faceIndex = face_index;
+
+        isect.material = material;
+        isect.area_light = area_light;
+
+        return isect;
     }
 };
 
+struct ShadowRay {
+    // unoccluded() tests both directions
+    Ray to_light;
+    Ray from_light;
+    SampledSpectrum Ld;
+};
+
 struct MISParameter {
     bool specular_bounce = true;
     bool any_non_specular_bounces = false;
@@ -82,7 +165,7 @@ static __global__ void gpu_init_stratified_samplers(Sampler *samplers,
 
 static __global__ void gpu_init_path_state(WavefrontPathIntegrator::PathState *path_state) {
     const uint worker_idx = blockIdx.x * blockDim.x + threadIdx.x;
-    if (worker_idx >= PATH_POOL_SIZE) {
+    if (worker_idx >= path_state->pool_size) {
         return;
     }
 
@@ -93,11 +176,11 @@ __global__ void control_logic(WavefrontPathIntegrator::PathState *path_state,
                               WavefrontPathIntegrator::Queues *queues, const uint max_depth,
                               const IntegratorBase *base) {
     const uint path_idx = blockIdx.x * blockDim.x + threadIdx.x;
-    if (path_idx >= PATH_POOL_SIZE || path_state->finished[path_idx]) {
+    if (path_idx >= path_state->pool_size || path_state->finished[path_idx]) {
         return;
     }
 
-    auto &isect = path_state->shape_intersections[path_idx]->interaction;
+    const auto &surface = path_state->surface_records[path_idx];
     const auto ray = path_state->camera_rays[path_idx].ray;
     auto &lambda = path_state->lambdas[path_idx];
 
@@ -110,7 +193,7 @@ __global__ void control_logic(WavefrontPathIntegrator::PathState *path_state,
         path_state->mis_parameters[path_idx].prev_interaction_light_sample_ctx;
     const auto pdf_bsdf = path_state->mis_parameters[path_idx].pdf_bsdf;
 
-    bool should_terminate_path = !path_state->shape_intersections[path_idx].has_value() ||
+    bool should_terminate_path = !surface.has_value() ||
                                  path_length > max_depth || !beta.is_positive();
 
     if (!should_terminate_path && path_length > 8) {
@@ -155,25 +238,30 @@ __global__ void control_logic(WavefrontPathIntegrator::PathState *path_state,
         }
 
         const uint queue_idx = atomicAdd(&queues->frame_buffer_counter, 1);
+        const auto pixel_idx = path_state->pixel_indices[path_idx];
+        const auto sample_idx = path_state->sample_indices[path_idx];
         queues->frame_buffer_queue[queue_idx] = FrameBuffer{
-            .pixel_idx = path_state->pixel_indices[path_idx],
-            .sample_idx = path_state->sample_indices[path_idx],
+            .pixel_idx = pixel_idx,
+            .sample_idx = sample_idx,
             .radiance = L * path_state->camera_rays[path_idx].weight,
             .lambda = lambda,
             .weight = path_state->camera_samples[path_idx].filter_weight,
         };
+        queues->frame_buffer_sort.keys[queue_idx] =
+            (static_cast<unsigned long long>(pixel_idx) << 32) | sample_idx;
+        queues->frame_buffer_sort.indices[queue_idx] = queue_idx;
 
         queues->new_paths->append_path(path_idx);
         return;
     }
 
-    SampledSpectrum Le = isect.le(-ray.d, lambda);
+    SampledSpectrum Le = surface.le(-ray.d, lambda);
     if (Le.is_positive()) {
         if (path_length == 0 || specular_bounce)
             path_state->L[path_idx] += beta * Le;
         else {
             // Compute MIS weight for area light
-            auto area_light = isect.area_light;
+            auto area_light = surface.area_light;
 
             FloatType pdf_light =
                 base->light_sampler->pmf(prev_interaction_light_sample_ctx, area_light) *
@@ -188,7 +276,7 @@ __global__ void control_logic(WavefrontPathIntegrator::PathState *path_state,
 
     path_state->path_length[path_idx] += 1;
 
-    switch (isect.material->get_material_type()) {
+    switch (surface.material->get_material_type()) {
 
     case Material::Type::conductor: {
         queues->conductor_material->append_path(path_idx);
@@ -230,29 +318,34 @@ __global__ void control_logic(WavefrontPathIntegrator::PathState *path_state,
 }
 
 __global__ void write_frame_buffer(Film *film, WavefrontPathIntegrator::Queues *queues) {
-    const uint queue_idx = blockIdx.x * blockDim.x + threadIdx.x;
-    if (queue_idx >= queues->frame_buffer_counter) {
+    const uint sorted_idx = blockIdx.x * blockDim.x + threadIdx.x;
+    if (sorted_idx >= queues->frame_buffer_counter) {
         return;
     }
 
-    const auto pixel_idx = queues->frame_buffer_queue[queue_idx].pixel_idx;
-    if (queue_idx > 0 && pixel_idx == queues->frame_buffer_queue[queue_idx - 1].pixel_idx) {
+    // entries are visited through indices sorted by (pixel, sample)
+    const auto sorted_indices = queues->frame_buffer_sort.sorted_indices;
+    const auto frame_buffer_queue = queues->frame_buffer_queue;
+
+    const auto pixel_idx = frame_buffer_queue[sorted_indices[sorted_idx]].pixel_idx;
+    if (sorted_idx > 0 &&
+        pixel_idx == frame_buffer_queue[sorted_indices[sorted_idx - 1]].pixel_idx) {
         return;
     }
 
-    for (uint idx = queue_idx; idx < queues->frame_buffer_counter &&
-                               queues->frame_buffer_queue[idx].pixel_idx == pixel_idx;
+    for (uint idx = sorted_idx; idx < queues->frame_buffer_counter &&
+                                frame_buffer_queue[sorted_indices[idx]].pixel_idx == pixel_idx;
          ++idx) {
         // make sure the same pixels are written by the same thread
-        const auto &frame_buffer = queues->frame_buffer_queue[idx];
+        const auto &frame_buffer = frame_buffer_queue[sorted_indices[idx]];
         film->add_sample(frame_buffer.pixel_idx, frame_buffer.radiance, frame_buffer.lambda,
                          frame_buffer.weight);
     }
 }
 
-__global__ void fill_new_path_queue(WavefrontPathIntegrator::Queues *queues) {
+__global__ void fill_new_path_queue(WavefrontPathIntegrator::Queues *queues, uint pool_size) {
     const uint worker_idx = blockIdx.x * blockDim.x + threadIdx.x;
-    if (worker_idx >= PATH_POOL_SIZE) {
+    if (worker_idx >= pool_size) {
         return;
     }
 
@@ -261,7 +354,8 @@ __global__ void fill_new_path_queue(WavefrontPathIntegrator::Queues *queues) {
 
 __global__ void generate_new_path(WavefrontPathIntegrator::PathState *path_state,
                                   WavefrontPathIntegrator::Queues *queues,
-                                  const IntegratorBase *base) {
+                                  const IntegratorBase *base, const Film *film,
+                                  const FloatType noise_threshold) {
     const uint queue_idx = blockIdx.x * blockDim.x + threadIdx.x;
     if (queue_idx >= queues->new_paths->counter) {
         return;
@@ -269,17 +363,26 @@ __global__ void generate_new_path(WavefrontPathIntegrator::PathState *path_state
 
     const uint path_idx = queues->new_paths->queue_array[queue_idx];
 
-    const auto unique_path_id = atomicAdd(&path_state->global_path_counter, 1);
-    if (unique_path_id >= path_state->total_path_num) {
-        path_state->finished[path_idx] = true;
-        return;
-    }
-
     const uint width = path_state->image_resolution.x;
     const uint height = path_state->image_resolution.y;
 
-    const uint pixel_idx = unique_path_id % (width * height);
-    const uint sample_idx = unique_path_id / (width * height);
+    uint pixel_idx = 0;
+    uint sample_idx = 0;
+    while (true) {
+        const auto unique_path_id = atomicAdd(&path_state->global_path_counter, 1);
+        if (unique_path_id >= path_state->total_path_num) {
+            path_state->finished[path_idx] = true;
+            return;
+        }
+
+        pixel_idx = unique_path_id % (width * height);
+        sample_idx = unique_path_id / (width * height);
+
+        // samples of converged pixels are skipped, this path slot goes to a noisier pixel instead
+        if (noise_threshold <= 0 || !film->is_converged(pixel_idx, noise_threshold)) {
+            break;
+        }
+    }
 
     auto sampler = &path_state->samplers[path_idx];
 
@@ -303,31 +406,109 @@ __global__ void generate_new_path(WavefrontPathIntegrator::PathState *path_state
     queues->rays->append_path(path_idx);
 }
 
-__global__ void gpu_evaluate_material(WavefrontPathIntegrator::Queues::SingleQueue *material_queue,
-                                      WavefrontPathIntegrator *integrator) {
+__global__ void compute_material_sort_keys(
+    const WavefrontPathIntegrator::Queues::SingleQueue *material_queue,
+    WavefrontPathIntegrator *integrator) {
     const uint queue_idx = blockIdx.x * blockDim.x + threadIdx.x;
     if (queue_idx >= material_queue->counter) {
         return;
     }
 
+    const uint path_idx = material_queue->queue_array[queue_idx];
+    const auto material = integrator->path_state.surface_records[path_idx].material;
+
+    // materials are interned, so the same pointer also means the same textures
+    integrator->queues.queue_sort.keys[queue_idx] = reinterpret_cast<uintptr_t>(material);
+}
+
+// shades the first num_evaluated paths of the queue, those missing a texture tile go to
+// missed_queue
+__global__ void gpu_evaluate_material(const WavefrontPathIntegrator::Queues::SingleQueue *queue,
+                                      const uint num_evaluated,
+                                      WavefrontPathIntegrator::Queues::SingleQueue *missed_queue,
+                                      WavefrontPathIntegrator *integrator) {
+    const uint queue_idx = blockIdx.x * blockDim.x + threadIdx.x;
+    if (queue_idx >= num_evaluated) {
+        return;
+    }
+
     auto path_state = &integrator->path_state;
 
-    const uint path_idx = material_queue->queue_array[queue_idx];
+    const uint path_idx = queue->queue_array[queue_idx];
 
     auto &lambda = path_state->lambdas[path_idx];
 
     auto sampler = &path_state->samplers[path_idx];
 
-    auto &isect = path_state->shape_intersections[path_idx]->interaction;
+    const auto texture_pool = integrator->texture_pool;
+    if (texture_pool != nullptr) {
+        texture_pool->clear_missed(queue_idx);
+    }
 
-    path_state->bsdf[path_idx] =
+    // the interaction and the BSDF only live through this stage: they're rebuilt from the
+    // surface record on every bounce instead of being stored per path
+    auto isect = path_state->surface_records[path_idx].to_surface_interaction(
+        -path_state->camera_rays[path_idx].ray.d);
+    auto bsdf =
         isect.get_bsdf(lambda, integrator->base->camera, sampler->get_samples_per_pixel());
 
-    integrator->sample_bsdf(path_idx, path_state);
+    if (texture_pool != nullptr && texture_pool->has_missed(queue_idx)) {
+        // building the BSDF consumes no sample: the path is left as it is until its tiles
+        // are loaded
+        missed_queue->append_path(path_idx);
+        return;
+    }
+
+    if (integrator->sample_bsdf(path_idx, isect, bsdf, path_state)) {
+        integrator->queues.shadow_rays->append_path(path_idx);
+    }
 
     integrator->queues.rays->append_path(path_idx);
 }
 
+__global__ void gpu_trace_shadow_rays(WavefrontPathIntegrator::PathState *path_state,
+                                      WavefrontPathIntegrator::Queues *queues,
+                                      const IntegratorBase *base) {
+    const uint queue_idx = blockIdx.x * blockDim.x + threadIdx.x;
+    if (queue_idx >= queues->shadow_rays->counter) {
+        return;
+    }
+
+    const uint path_idx = queues->shadow_rays->queue_array[queue_idx];
+    const auto &shadow_ray = path_state->shadow_rays[path_idx];
+
+    if (!base->fast_intersect(shadow_ray.to_light, 0.6) &&
+        !base->fast_intersect(shadow_ray.from_light, 0.6)) {
+        path_state->L[path_idx] += shadow_ray.Ld;
+    }
+}
+
+// 3 bits for the direction octant followed by a 27-bit morton code of the origin
+constexpr uint RAY_SORT_KEY_BITS = 30;
+
+__global__ void compute_ray_sort_keys(WavefrontPathIntegrator::PathState *path_state,
+                                      WavefrontPathIntegrator::Queues *queues,
+                                      const Bounds3f scene_bounds) {
+    const uint ray_queue_idx = blockIdx.x * blockDim.x + threadIdx.x;
+    if (ray_queue_idx >= queues->rays->counter) {
+        return;
+    }
+
+    const uint path_idx = queues->rays->queue_array[ray_queue_idx];
+    const auto &ray = path_state->camera_rays[path_idx].ray;
+
+    constexpr uint morton_scale = 1 << 9;
+    const auto offset = scene_bounds.offset(ray.o);
+    const auto quantize = [](const FloatType x) {
+        return uint32_t(clamp<FloatType>(x * morton_scale, 0, morton_scale - 1));
+    };
+
+    const uint octant = (ray.d.x < 0 ? 4 : 0) | (ray.d.y < 0 ? 2 : 0) | (ray.d.z < 0 ? 1 : 0);
+
+    queues->queue_sort.keys[ray_queue_idx] =
+        (octant << 27) | encode_morton3(quantize(offset.x), quantize(offset.y), quantize(offset.z));
+}
+
 __global__ void ray_cast(WavefrontPathIntegrator::PathState *path_state,
                          WavefrontPathIntegrator::Queues *queues, const IntegratorBase *base) {
     const uint ray_queue_idx = blockIdx.x * blockDim.x + threadIdx.x;
@@ -339,39 +520,44 @@ __global__ void ray_cast(WavefrontPathIntegrator::PathState *path_state,
 
     const auto camera_ray = path_state->camera_rays[path_idx];
 
-    path_state->shape_intersections[path_idx] = base->intersect(camera_ray.ray, Infinity);
+    path_state->surface_records[path_idx].init(base->intersect(camera_ray.ray, Infinity));
 }
 
 PBRT_CPU_GPU
-void WavefrontPathIntegrator::sample_bsdf(uint path_idx, PathState *path_state) const {
-    auto &isect = path_state->shape_intersections[path_idx]->interaction;
+bool WavefrontPathIntegrator::sample_bsdf(uint path_idx, const SurfaceInteraction &isect,
+                                          BSDF &bsdf, PathState *path_state) const {
     auto &lambda = path_state->lambdas[path_idx];
 
     auto &ray = path_state->camera_rays[path_idx].ray;
     auto sampler = &path_state->samplers[path_idx];
 
     if (regularize && path_state->mis_parameters[path_idx].any_non_specular_bounces) {
-        path_state->bsdf[path_idx].regularize();
+        bsdf.regularize();
     }
 
-    if (pbrt::is_non_specular(path_state->bsdf[path_idx].flags())) {
-        SampledSpectrum Ld = sample_ld(isect, &path_state->bsdf[path_idx], lambda, sampler);
-        path_state->L[path_idx] += path_state->beta[path_idx] * Ld;
+    bool has_shadow_ray = false;
+    if (pbrt::is_non_specular(bsdf.flags())) {
+        auto shadow_ray = sample_ld(isect, &bsdf, lambda, sampler);
+        if (shadow_ray.has_value()) {
+            shadow_ray->Ld *= path_state->beta[path_idx];
+            path_state->shadow_rays[path_idx] = *shadow_ray;
+            has_shadow_ray = true;
+        }
     }
 
     // Sample BSDF to get new path direction
     Vector3f wo = -ray.d;
     FloatType u = sampler->get_1d();
-    auto bs = path_state->bsdf[path_idx].sample_f(wo, u, sampler->get_2d());
+    auto bs = bsdf.sample_f(wo, u, sampler->get_2d());
     if (!bs) {
         path_state->beta[path_idx] = SampledSpectrum(0.0);
-        return;
+        return has_shadow_ray;
     }
 
     path_state->beta[path_idx] *= bs->f * bs->wi.abs_dot(isect.shading.n.to_vector3()) / bs->pdf;
 
     path_state->mis_parameters[path_idx].pdf_bsdf =
-        bs->pdf_is_proportional ? path_state->bsdf[path_idx].pdf(wo, bs->wi) : bs->pdf;
+        bs->pdf_is_proportional ? bsdf.pdf(wo, bs->wi) : bs->pdf;
     path_state->mis_parameters[path_idx].specular_bounce = bs->is_specular();
     path_state->mis_parameters[path_idx].any_non_specular_bounces |= (!bs->is_specular());
 
@@ -382,6 +568,8 @@ void WavefrontPathIntegrator::sample_bsdf(uint path_idx, PathState *path_state)
     path_state->mis_parameters[path_idx].prev_interaction_light_sample_ctx = isect;
 
     path_state->camera_rays[path_idx].ray = isect.spawn_ray(bs->wi);
+
+    return has_shadow_ray;
 }
 
 void WavefrontPathIntegrator::evaluate_material(const Material::Type material_type) {
@@ -393,14 +581,93 @@ void WavefrontPathIntegrator::evaluate_material(const Material::Type material_ty
     constexpr uint threads = 256;
     const auto blocks = divide_and_ceil(material_queue->counter, threads);
 
-    gpu_evaluate_material<<<blocks, threads>>>(material_queue, this);
+    if (sort_materials) {
+        compute_material_sort_keys<<<blocks, threads>>>(material_queue, this);
+        CHECK_CUDA_ERROR(cudaDeviceSynchronize());
+
+        queues.queue_sort.sort(material_queue, sizeof(uintptr_t) * 8);
+    }
+
+    if (texture_pool == nullptr) {
+        gpu_evaluate_material<<<blocks, threads>>>(material_queue, material_queue->counter,
+                                                   nullptr, this);
+        CHECK_CUDA_ERROR(cudaDeviceSynchronize());
+        return;
+    }
+
+    uint retry_idx = 0;
+    queues.texture_retry[retry_idx]->counter = 0;
+
+    texture_pool->begin_launch();
+    gpu_evaluate_material<<<blocks, threads>>>(material_queue, material_queue->counter,
+                                               queues.texture_retry[retry_idx], this);
+    CHECK_CUDA_ERROR(cudaDeviceSynchronize());
+
+    // a path missing some tile is evaluated again once the requested tiles are loaded. when the
+    // pool can't hold the tiles of every path left at once, fewer paths are evaluated per
+    // launch: the paths of a launch whose tiles all got loaded go first in the next one and
+    // find every tile they need
+    uint num_evaluated = material_queue->counter;
+    while (queues.texture_retry[retry_idx]->counter > 0) {
+        const auto retry_queue = queues.texture_retry[retry_idx];
+        const auto missed_queue = queues.texture_retry[1 - retry_idx];
+
+        if (!texture_pool->load_requested_tiles()) {
+            if (num_evaluated == 1) {
+                printf("\n%s(): a single path needs more texture tiles than the pool holds, "
+                       "raise --texture-cache-mb\n",
+                       __func__);
+                REPORT_FATAL_ERROR();
+            }
+            num_evaluated = divide_and_ceil(num_evaluated, 2u);
+        }
+        num_evaluated = std::min(num_evaluated, retry_queue->counter);
+
+        missed_queue->counter = 0;
+        texture_pool->begin_launch();
+        gpu_evaluate_material<<<divide_and_ceil(num_evaluated, threads), threads>>>(
+            retry_queue, num_evaluated, missed_queue, this);
+        CHECK_CUDA_ERROR(cudaDeviceSynchronize());
+
+        // paths not evaluated this time queue up behind the ones that missed again
+        const uint num_skipped = retry_queue->counter - num_evaluated;
+        CHECK_CUDA_ERROR(cudaMemcpy(missed_queue->queue_array + missed_queue->counter,
+                                    retry_queue->queue_array + num_evaluated,
+                                    sizeof(uint) * num_skipped, cudaMemcpyDefault));
+        missed_queue->counter += num_skipped;
+
+        retry_idx = 1 - retry_idx;
+    }
+}
+
+void WavefrontPathIntegrator::sort_ray_queue() {
+    constexpr uint threads = 256;
+    const auto blocks = divide_and_ceil(queues.rays->counter, threads);
+
+    compute_ray_sort_keys<<<blocks, threads>>>(&path_state, &queues, base->bvh->bounds());
     CHECK_CUDA_ERROR(cudaDeviceSynchronize());
+
+    queues.queue_sort.sort(queues.rays, RAY_SORT_KEY_BITS);
+}
+
+void WavefrontPathIntegrator::trace_shadow_rays() {
+    if (queues.shadow_rays->counter <= 0) {
+        return;
+    }
+
+    constexpr uint threads = 256;
+    const auto blocks = divide_and_ceil(queues.shadow_rays->counter, threads);
+
+    gpu_trace_shadow_rays<<<blocks, threads>>>(&path_state, &queues, base);
+    CHECK_CUDA_ERROR(cudaDeviceSynchronize());
+
+    queues.shadow_rays->counter = 0;
 }
 
 PBRT_CPU_GPU
 void WavefrontPathIntegrator::PathState::init_new_path(uint path_idx) {
     finished[path_idx] = false;
-    shape_intersections[path_idx].reset();
+    surface_records[path_idx].material = nullptr;
 
     L[path_idx] = SampledSpectrum(0.0);
     beta[path_idx] = SampledSpectrum(1.0);
@@ -409,32 +676,41 @@ void WavefrontPathIntegrator::PathState::init_new_path(uint path_idx) {
     mis_parameters[path_idx].init();
 }
 
-void WavefrontPathIntegrator::PathState::create(uint samples_per_pixel, const Point2i &_resolution,
+void WavefrontPathIntegrator::PathState::create(uint samples_per_pixel,
+                                                const std::pair<uint, uint> &sample_range,
+                                                const Point2i &_resolution, const uint _pool_size,
                                                 const std::string &sampler_type,
                                                 GPUMemoryAllocator &allocator) {
     image_resolution = _resolution;
-    global_path_counter = 0;
-    total_path_num = samples_per_pixel * image_resolution.x * image_resolution.y;
+    pool_size = _pool_size;
+
+    // path ids run pixel-fastest, so a sample range is a contiguous range of ids
+    const auto num_pixels =
+        static_cast<unsigned long long>(image_resolution.x) * image_resolution.y;
+    global_path_counter = sample_range.first * num_pixels;
+    total_path_num = sample_range.second * num_pixels;
 
-    camera_samples = allocator.allocate<CameraSample>(PATH_POOL_SIZE);
-    camera_rays = allocator.allocate<CameraRay>(PATH_POOL_SIZE);
-    lambdas = allocator.allocate<SampledWavelengths>(PATH_POOL_SIZE);
+    camera_samples = allocator.allocate<CameraSample>(pool_size);
+    camera_rays = allocator.allocate<CameraRay>(pool_size);
+    lambdas = allocator.allocate<SampledWavelengths>(pool_size);
 
-    L = allocator.allocate<SampledSpectrum>(PATH_POOL_SIZE);
-    beta = allocator.allocate<SampledSpectrum>(PATH_POOL_SIZE);
-    shape_intersections = allocator.allocate<pbrt::optional<ShapeIntersection>>(PATH_POOL_SIZE);
+    L = allocator.allocate<SampledSpectrum>(pool_size);
+    beta = allocator.allocate<SampledSpectrum>(pool_size);
+    surface_records = allocator.allocate<SurfaceRecord>(pool_size);
 
-    path_length = allocator.allocate<uint>(PATH_POOL_SIZE);
-    finished = allocator.allocate<bool>(PATH_POOL_SIZE);
-    pixel_indices = allocator.allocate<uint>(PATH_POOL_SIZE);
-    sample_indices = allocator.allocate<uint>(PATH_POOL_SIZE);
+    path_length = allocator.allocate<uint>(pool_size);
+    finished = allocator.allocate<bool>(pool_size);
+    pixel_indices = allocator.allocate<uint>(pool_size);
+    sample_indices = allocator.allocate<uint>(pool_size);
 
-    bsdf = allocator.allocate<BSDF>(PATH_POOL_SIZE);
-    mis_parameters = allocator.allocate<MISParameter>(PATH_POOL_SIZE);
-    samplers = allocator.allocate<Sampler>(PATH_POOL_SIZE);
+    mis_parameters = allocator.allocate<MISParameter>(pool_size);
+    shadow_rays = allocator.allocate<ShadowRay>(pool_size);
+
+    GPUMemoryAllocator::Scope memory_scope(MemoryCategory::Sampler);
+    samplers = allocator.allocate<Sampler>(pool_size);
 
     constexpr uint threads = 1024;
-    uint blocks = divide_and_ceil<uint>(PATH_POOL_SIZE, threads);
+    uint blocks = divide_and_ceil<uint>(pool_size, threads);
 
     if (sampler_type == "stratified") {
         const auto samples_per_dimension = static_cast<int>(std::sqrt(samples_per_pixel));
@@ -442,73 +718,172 @@ void WavefrontPathIntegrator::PathState::create(uint samples_per_pixel, const Po
             REPORT_FATAL_ERROR();
         }
 
-        auto stratified_samplers = allocator.allocate<StratifiedSampler>(PATH_POOL_SIZE);
+        auto stratified_samplers = allocator.allocate<StratifiedSampler>(pool_size);
 
         gpu_init_stratified_samplers<<<blocks, threads>>>(samplers, stratified_samplers,
-                                                          samples_per_dimension, PATH_POOL_SIZE);
+                                                          samples_per_dimension, pool_size);
         CHECK_CUDA_ERROR(cudaDeviceSynchronize());
     } else if (sampler_type == "independent") {
-        auto independent_samplers = allocator.allocate<IndependentSampler>(PATH_POOL_SIZE);
+        auto independent_samplers = allocator.allocate<IndependentSampler>(pool_size);
 
         gpu_init_independent_samplers<<<blocks, threads>>>(samplers, independent_samplers,
-                                                           PATH_POOL_SIZE);
+                                                           pool_size);
         CHECK_CUDA_ERROR(cudaDeviceSynchronize());
     } else {
         REPORT_FATAL_ERROR();
     }
 
-    gpu_init_path_state<<<PATH_POOL_SIZE, threads>>>(this);
+    gpu_init_path_state<<<blocks, threads>>>(this);
     CHECK_CUDA_ERROR(cudaDeviceSynchronize());
 }
 
-void WavefrontPathIntegrator::Queues::init(GPUMemoryAllocator &allocator) {
-    new_paths = build_new_queue(allocator);
-    rays = build_new_queue(allocator);
-    conductor_material = build_new_queue(allocator);
-    coated_conductor_material = build_new_queue(allocator);
-    coated_diffuse_material = build_new_queue(allocator);
-    dielectric_material = build_new_queue(allocator);
-    diffuse_material = build_new_queue(allocator);
-    diffuse_transmission_material = build_new_queue(allocator);
+void WavefrontPathIntegrator::Queues::init(const uint pool_size, const bool texture_paging,
+                                           GPUMemoryAllocator &allocator) {
+    new_paths = build_new_queue(pool_size, allocator);
+    rays = build_new_queue(pool_size, allocator);
+    shadow_rays = build_new_queue(pool_size, allocator);
+    conductor_material = build_new_queue(pool_size, allocator);
+    coated_conductor_material = build_new_queue(pool_size, allocator);
+    coated_diffuse_material = build_new_queue(pool_size, allocator);
+    dielectric_material = build_new_queue(pool_size, allocator);
+    diffuse_material = build_new_queue(pool_size, allocator);
+    diffuse_transmission_material = build_new_queue(pool_size, allocator);
+
+    for (auto &queue : texture_retry) {
+        queue = texture_paging ? build_new_queue(pool_size, allocator) : nullptr;
+    }
 
     frame_buffer_counter = 0;
-    frame_buffer_queue = allocator.allocate<FrameBuffer>(PATH_POOL_SIZE);
+    frame_buffer_queue = allocator.allocate<FrameBuffer>(pool_size);
+
+    frame_buffer_sort.keys = allocator.allocate<unsigned long long>(pool_size);
+    frame_buffer_sort.sorted_keys = allocator.allocate<unsigned long long>(pool_size);
+    frame_buffer_sort.indices = allocator.allocate<uint>(pool_size);
+    frame_buffer_sort.sorted_indices = allocator.allocate<uint>(pool_size);
+
+    frame_buffer_sort.temp_storage_size = 0;
+    CHECK_CUDA_ERROR(cub::DeviceRadixSort::SortPairs(
+        nullptr, frame_buffer_sort.temp_storage_size, frame_buffer_sort.keys,
+        frame_buffer_sort.sorted_keys, frame_buffer_sort.indices, frame_buffer_sort.sorted_indices,
+        pool_size));
+    frame_buffer_sort.temp_storage =
+        allocator.allocate<uint8_t>(frame_buffer_sort.temp_storage_size);
+
+    queue_sort.init(pool_size, allocator);
+}
+
+void WavefrontPathIntegrator::Queues::FrameBufferSort::sort(const uint num) {
+    CHECK_CUDA_ERROR(cub::DeviceRadixSort::SortPairs(temp_storage, temp_storage_size, keys,
+                                                     sorted_keys, indices, sorted_indices, num));
+    CHECK_CUDA_ERROR(cudaDeviceSynchronize());
+}
+
+void WavefrontPathIntegrator::Queues::QueueSort::init(const uint pool_size,
+                                                     GPUMemoryAllocator &allocator) {
+    keys = allocator.allocate<unsigned long long>(pool_size);
+    sorted_keys = allocator.allocate<unsigned long long>(pool_size);
+    sorted_path_indices = allocator.allocate<uint>(pool_size);
+
+    temp_storage_size = 0;
+    CHECK_CUDA_ERROR(cub::DeviceRadixSort::SortPairs(nullptr, temp_storage_size, keys, sorted_keys,
+                                                     sorted_path_indices, sorted_path_indices,
+                                                     pool_size));
+    temp_storage = allocator.allocate<uint8_t>(temp_storage_size);
+}
+
+void WavefrontPathIntegrator::Queues::QueueSort::sort(SingleQueue *queue, const uint key_bits) {
+    if (queue->counter <= 1) {
+        return;
+    }
+
+    CHECK_CUDA_ERROR(cub::DeviceRadixSort::SortPairs(temp_storage, temp_storage_size, keys,
+                                                     sorted_keys, queue->queue_array,
+                                                     sorted_path_indices, queue->counter, 0,
+                                                     key_bits));
+    CHECK_CUDA_ERROR(cudaDeviceSynchronize());
+
+    // both arrays hold pool_size entries: hand the sorted one to the queue
+    std::swap(queue->queue_array, sorted_path_indices);
 }
 
 WavefrontPathIntegrator::Queues::SingleQueue *
-WavefrontPathIntegrator::Queues::build_new_queue(GPUMemoryAllocator &allocator) {
-    auto queue = allocator.allocate<SingleQueue>(PATH_POOL_SIZE);
+WavefrontPathIntegrator::Queues::build_new_queue(const uint pool_size,
+                                                 GPUMemoryAllocator &allocator) {
+    auto queue = allocator.allocate<SingleQueue>();
     queue->counter = 0;
-    queue->queue_array = allocator.allocate<uint>(PATH_POOL_SIZE);
+    queue->queue_array = allocator.allocate<uint>(pool_size);
 
     return queue;
 }
 
-WavefrontPathIntegrator *WavefrontPathIntegrator::create(uint samples_per_pixel,
-                                                         const std::string &sampler_type,
-                                                         const ParameterDictionary &parameters,
-                                                         const IntegratorBase *base,
-                                                         GPUMemoryAllocator &allocator) {
+static uint choose_path_pool_size(const ulong total_path_num, const bool texture_paging) {
+    // every pool-sized array in PathState and Queues, plus the largest concrete sampler
+    const ulong bytes_per_path =
+        sizeof(CameraSample) + sizeof(CameraRay) + sizeof(SampledWavelengths) +
+        2 * sizeof(SampledSpectrum) + sizeof(SurfaceRecord) +
+        3 * sizeof(uint) + sizeof(bool) + sizeof(MISParameter) +
+        sizeof(ShadowRay) + sizeof(Sampler) +
+        std::max(sizeof(StratifiedSampler), sizeof(IndependentSampler)) + 9 * sizeof(uint) +
+        sizeof(FrameBuffer) + 4 * sizeof(unsigned long long) + 3 * sizeof(uint) +
+        (texture_paging ? 2 * sizeof(uint) + sizeof(bool) : 0);
+
+    size_t free_memory = 0;
+    size_t total_memory = 0;
+    CHECK_CUDA_ERROR(cudaMemGetInfo(&free_memory, &total_memory));
+
+    const ulong pool_size = std::min<ulong>(free_memory / 2 / bytes_per_path, total_path_num);
+    return std::clamp<ulong>(pool_size, 1, std::numeric_limits<uint>::max());
+}
+
+WavefrontPathIntegrator *
+WavefrontPathIntegrator::create(uint samples_per_pixel, const std::pair<uint, uint> &sample_range,
+                                const std::string &sampler_type,
+                                const ParameterDictionary &parameters, const IntegratorBase *base,
+                                const std::optional<uint> path_pool_size,
+                                const std::optional<FloatType> noise_threshold,
+                                TexturePool *texture_pool, GPUMemoryAllocator &allocator) {
     auto integrator = allocator.allocate<WavefrontPathIntegrator>();
 
     integrator->samples_per_pixel = samples_per_pixel;
+    integrator->noise_threshold = noise_threshold.value_or(0);
+
+    const auto resolution = base->camera->get_camerabase()->resolution;
+    const auto pool_size = path_pool_size.has_value()
+                               ? path_pool_size.value()
+                               : choose_path_pool_size(
+                                     ulong(sample_range.second - sample_range.first) *
+                                         resolution.x * resolution.y,
+                                     texture_pool != nullptr);
+    if (pool_size == 0) {
+        printf("\n%s(): path pool size must be positive\n", __func__);
+        REPORT_FATAL_ERROR();
+    }
 
     integrator->base = base;
-    integrator->path_state.create(samples_per_pixel, base->camera->get_camerabase()->resolution,
+    integrator->path_state.create(samples_per_pixel, sample_range, resolution, pool_size,
                                   sampler_type, allocator);
 
-    integrator->queues.init(allocator);
+    integrator->queues.init(pool_size, texture_pool != nullptr, allocator);
+
+    // material stage threads are indexed by their position in the queue
+    integrator->texture_pool = texture_pool;
+    if (texture_pool != nullptr) {
+        texture_pool->track_lookups(pool_size, allocator);
+    }
 
     integrator->max_depth = parameters.get_integer("maxdepth", 5);
     integrator->regularize = parameters.get_bool("regularize", false);
+    integrator->sort_rays = parameters.get_bool("sortrays", false);
+    integrator->sort_materials = parameters.get_bool("sortmaterials", false);
 
     return integrator;
 }
 
 PBRT_CPU_GPU
-SampledSpectrum WavefrontPathIntegrator::sample_ld(const SurfaceInteraction &intr, const BSDF *bsdf,
-                                                   SampledWavelengths &lambda,
-                                                   Sampler *sampler) const {
+pbrt::optional<ShadowRay> WavefrontPathIntegrator::sample_ld(const SurfaceInteraction &intr,
+                                                             const BSDF *bsdf,
+                                                             SampledWavelengths &lambda,
+                                                             Sampler *sampler) const {
     // Initialize _LightSampleContext_ for light sampling
     LightSampleContext ctx(intr);
     // Try to nudge the light sampling position to correct side of the surface
@@ -525,14 +900,14 @@ SampledSpectrum WavefrontPathIntegrator::sample_ld(const SurfaceInteraction &int
 
     Point2f uLight = sampler->get_2d();
     if (!sampled_light) {
-        return SampledSpectrum(0);
+        return {};
     }
 
     // Sample a point on the light source for direct lighting
     auto light = sampled_light->light;
     auto ls = light->sample_li(ctx, uLight, lambda);
     if (!ls || !ls->l.is_positive() || ls->pdf == 0) {
-        return SampledSpectrum(0);
+        return {};
     }
 
     // Evaluate BSDF for light sample and check light visibility
@@ -540,25 +915,31 @@ SampledSpectrum WavefrontPathIntegrator::sample_ld(const SurfaceInteraction &int
     Vector3f wi = ls->wi;
     SampledSpectrum f = bsdf->f(wo, wi) * wi.abs_dot(intr.shading.n.to_vector3());
 
-    if (!f.is_positive() || !base->unoccluded(intr, ls->p_light)) {
-        return SampledSpectrum(0);
+    if (!f.is_positive()) {
+        return {};
     }
 
     // Return light's contribution to reflected radiance
     FloatType pdf_light = sampled_light->p * ls->pdf;
-    if (pbrt::is_delta_light(light->get_light_type())) {
-        return ls->l * f / pdf_light;
+    SampledSpectrum Ld = ls->l * f / pdf_light;
+    if (!pbrt::is_delta_light(light->get_light_type())) {
+        FloatType pdf_bsdf = bsdf->pdf(wo, wi);
+        Ld = power_heuristic(1, pdf_light, 1, pdf_bsdf) * Ld;
     }
 
-    // for non delta light
-    FloatType pdf_bsdf = bsdf->pdf(wo, wi);
-    FloatType weight_light = power_heuristic(1, pdf_light, 1, pdf_bsdf);
-
-    return weight_light * ls->l * f / pdf_light;
+    return ShadowRay{
+        .to_light = intr.spawn_ray_to(ls->p_light),
+        .from_light = ls->p_light.spawn_ray_to(intr),
+        .Ld = Ld,
+    };
 }
 
-void WavefrontPathIntegrator::render(Film *film, const bool preview) {
-    printf("wavefront: path pool size: %u\n", PATH_POOL_SIZE);
+void WavefrontPathIntegrator::render(Film *film, const std::optional<FloatType> time_limit,
+                                     const CheckpointOption &checkpoint_option,
+                                     const bool preview) {
+    const auto start = std::chrono::system_clock::now();
+    const auto pool_size = path_state.pool_size;
+    printf("wavefront: path pool size: %u\n", pool_size);
 
     const auto image_resolution = this->path_state.image_resolution;
 
@@ -571,60 +952,148 @@ void WavefrontPathIntegrator::render(Film *film, const bool preview) {
 
     constexpr uint threads = 256;
 
-    // generate new paths for the whole pool
-    fill_new_path_queue<<<PATH_POOL_SIZE, threads>>>(&queues);
-    CHECK_CUDA_ERROR(cudaDeviceSynchronize());
+    const auto total_path_num = path_state.total_path_num;
+
+    // paths are numbered in the order they start: once the pool is drained, every path below the
+    // counter has reached the film and none above it has started, so the counter and the film
+    // are all the state there is
+    const std::string checkpoint_tag =
+        "wavefront-path " + std::to_string(image_resolution.x) + "x" +
+        std::to_string(image_resolution.y) + " spp " + std::to_string(samples_per_pixel) +
+        " range " + std::to_string(path_state.global_path_counter / num_pixels) + ":" +
+        std::to_string(total_path_num / num_pixels) + " scene " +
+        std::to_string(checkpoint_option.render_hash);
+
+    if (checkpoint_option.resume_file.has_value()) {
+        CheckpointReader reader(checkpoint_option.resume_file.value(), checkpoint_tag);
+        path_state.global_path_counter = reader.read<unsigned long long int>();
+        reader.read(film->get_pixels(), num_pixels);
+
+        printf("wavefront: resumed from `%s` at %llu/%llu samples\n",
+               checkpoint_option.resume_file->c_str(), path_state.global_path_counter,
+               total_path_num);
+    }
 
-    queues.new_paths->counter = PATH_POOL_SIZE;
-    queues.rays->counter = 0;
+    const auto write_checkpoint = [&]() {
+        CheckpointWriter writer(checkpoint_option.checkpoint_file.value(), checkpoint_tag);
+        writer.write(path_state.global_path_counter);
+        writer.write(film->get_pixels(), num_pixels);
+        writer.commit();
+    };
 
-    generate_new_path<<<divide_and_ceil(queues.new_paths->counter, threads), threads>>>(
-        &path_state, &queues, base);
-    CHECK_CUDA_ERROR(cudaDeviceSynchronize());
+    std::chrono::duration<FloatType> duration_ray_sorting{0};
+    std::chrono::duration<FloatType> duration_ray_casting{0};
 
-    while (queues.rays->counter > 0) {
-        ray_cast<<<divide_and_ceil(queues.rays->counter, threads), threads>>>(&path_state, &queues,
-                                                                              base);
+    auto last_checkpoint = std::chrono::system_clock::now();
+    bool time_limit_reached = false;
+
+    // the pool is filled at the start and again after each checkpoint
+    while (!time_limit_reached && path_state.global_path_counter < total_path_num) {
+        fill_new_path_queue<<<divide_and_ceil(pool_size, threads), threads>>>(&queues, pool_size);
         CHECK_CUDA_ERROR(cudaDeviceSynchronize());
 
-        // clear all queues before control stage
-        for (auto _queue : queues.get_all_queues()) {
-            _queue->counter = 0;
-        }
-        queues.frame_buffer_counter = 0;
+        queues.new_paths->counter = pool_size;
+        queues.rays->counter = 0;
 
-        control_logic<<<divide_and_ceil(PATH_POOL_SIZE, threads), threads>>>(&path_state, &queues,
-                                                                             max_depth, base);
+        generate_new_path<<<divide_and_ceil(queues.new_paths->counter, threads), threads>>>(
+            &path_state, &queues, base, film, noise_threshold);
         CHECK_CUDA_ERROR(cudaDeviceSynchronize());
 
-        if (queues.frame_buffer_counter > 0) {
-            // sort to make film writing deterministic
-            std::sort(queues.frame_buffer_queue + 0,
-                      queues.frame_buffer_queue + queues.frame_buffer_counter, std::less{});
+        bool draining = false;
+        while (queues.rays->counter > 0) {
+            const auto start_ray_sorting = std::chrono::system_clock::now();
+            if (sort_rays) {
+                sort_ray_queue();
+            }
 
-            write_frame_buffer<<<divide_and_ceil(queues.frame_buffer_counter, threads), threads>>>(
-                film, &queues);
+            const auto start_ray_casting = std::chrono::system_clock::now();
+            ray_cast<<<divide_and_ceil(queues.rays->counter, threads), threads>>>(
+                &path_state, &queues, base);
             CHECK_CUDA_ERROR(cudaDeviceSynchronize());
 
-            if (preview) {
-                film->copy_to_frame_buffer(gl_helper.gpu_frame_buffer);
-
-                const auto current_sample_idx =
-                    std::min<uint>(path_state.global_path_counter / num_pixels, samples_per_pixel);
+            duration_ray_sorting += start_ray_casting - start_ray_sorting;
+            duration_ray_casting += std::chrono::system_clock::now() - start_ray_casting;
 
-                gl_helper.draw_frame(
-                    GLHelper::assemble_title(FloatType(current_sample_idx) / samples_per_pixel));
+            // clear all queues before control stage
+            for (auto _queue : queues.get_all_queues()) {
+                _queue->counter = 0;
             }
-        }
+            queues.frame_buffer_counter = 0;
 
-        if (queues.new_paths->counter > 0) {
-            generate_new_path<<<divide_and_ceil(queues.new_paths->counter, threads), threads>>>(
-                &path_state, &queues, base);
+            control_logic<<<divide_and_ceil(pool_size, threads), threads>>>(&path_state, &queues,
+                                                                            max_depth, base);
             CHECK_CUDA_ERROR(cudaDeviceSynchronize());
+
+            if (queues.frame_buffer_counter > 0) {
+                // sort to make film writing deterministic
+                queues.frame_buffer_sort.sort(queues.frame_buffer_counter);
+
+                write_frame_buffer<<<divide_and_ceil(queues.frame_buffer_counter, threads),
+                                     threads>>>(film, &queues);
+                CHECK_CUDA_ERROR(cudaDeviceSynchronize());
+
+                if (preview) {
+                    film->copy_to_frame_buffer(gl_helper.gpu_frame_buffer);
+
+                    const auto current_sample_idx = std::min<uint>(
+                        path_state.global_path_counter / num_pixels, samples_per_pixel);
+
+                    gl_helper.draw_frame(GLHelper::assemble_title(
+                        FloatType(current_sample_idx) / samples_per_pixel));
+                }
+            }
+
+            if (!draining && path_state.global_path_counter < path_state.total_path_num) {
+                const auto now = std::chrono::system_clock::now();
+                if (time_limit.has_value() &&
+                    std::chrono::duration<FloatType>(now - start).count() >= time_limit.value()) {
+                    printf("wavefront: time limit reached after %llu/%llu samples\n",
+                           path_state.global_path_counter, total_path_num);
+                    time_limit_reached = true;
+                    draining = true;
+                } else if (checkpoint_option.checkpoint_file.has_value() &&
+                           std::chrono::duration<FloatType>(now - last_checkpoint).count() >=
+                               checkpoint_option.interval) {
+                    draining = true;
+                }
+
+                if (draining) {
+                    // generate_new_path retires every slot from now on
+                    path_state.total_path_num = path_state.global_path_counter;
+                }
+            }
+
+            if (queues.new_paths->counter > 0) {
+                generate_new_path<<<divide_and_ceil(queues.new_paths->counter, threads),
+                                    threads>>>(&path_state, &queues, base, film, noise_threshold);
+                CHECK_CUDA_ERROR(cudaDeviceSynchronize());
+            }
+
+            for (const auto material_type : Material::get_all_material_type()) {
+                evaluate_material(material_type);
+            }
+
+            // shadow rays are traced apart from shading, all at once
+            trace_shadow_rays();
         }
 
-        for (const auto material_type : Material::get_all_material_type()) {
-            evaluate_material(material_type);
+        if (draining) {
+            // retired slots still bumped the counter: resume from the drain point
+            path_state.global_path_counter = path_state.total_path_num;
+            path_state.total_path_num = total_path_num;
+
+            if (checkpoint_option.checkpoint_file.has_value()) {
+                write_checkpoint();
+                last_checkpoint = std::chrono::system_clock::now();
+            }
         }
     }
+
+    printf("wavefront: ray casting took %.2f seconds (ray sorting: %.2f, %s)\n",
+           duration_ray_casting.count(), duration_ray_sorting.count(),
+           sort_rays ? "enabled" : "disabled");
+
+    if (texture_pool != nullptr) {
+        texture_pool->print_statistics();
+    }
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <optional>
 #include <pbrt/base/material.h>
 #include <pbrt/euclidean_space/point2.h>
 
@@ -11,15 +12,18 @@ class SampledSpectrum;
 class SampledWavelengths;
 class Spectrum;
 class SurfaceInteraction;
+class TexturePool;
 
 class BSDF;
 
 struct CameraSample;
 struct CameraRay;
+struct CheckpointOption;
 struct FrameBuffer;
 struct MISParameter;
 struct IntegratorBase;
-struct ShapeIntersection;
+struct ShadowRay;
+struct SurfaceRecord;
 
 class WavefrontPathIntegrator {
   public:
@@ -32,25 +36,29 @@ class WavefrontPathIntegrator {
         SampledSpectrum *beta;
         Sampler *samplers;
 
-        pbrt::optional<ShapeIntersection> *shape_intersections;
+        SurfaceRecord *surface_records;
 
         uint *path_length;
         bool *finished;
 
-        BSDF *bsdf;
-
         MISParameter *mis_parameters;
 
+        ShadowRay *shadow_rays;
+
         uint *pixel_indices;
         uint *sample_indices;
 
         Point2i image_resolution;
 
+        uint pool_size;
+
         unsigned long long int global_path_counter;
         unsigned long long int total_path_num;
 
-        void create(uint samples_per_pixel, const Point2i &_resolution,
-                    const std::string &sampler_type, GPUMemoryAllocator &allocator);
+        // only samples [sample_range.first, sample_range.second) of each pixel are rendered
+        void create(uint samples_per_pixel, const std::pair<uint, uint> &sample_range,
+                    const Point2i &_resolution, uint _pool_size, const std::string &sampler_type,
+                    GPUMemoryAllocator &allocator);
 
         PBRT_CPU_GPU
         void init_new_path(uint path_idx);
@@ -70,6 +78,7 @@ class WavefrontPathIntegrator {
 
         SingleQueue *new_paths;
         SingleQueue *rays;
+        SingleQueue *shadow_rays;
 
         SingleQueue *conductor_material;
         SingleQueue *coated_conductor_material;
@@ -78,10 +87,44 @@ class WavefrontPathIntegrator {
         SingleQueue *diffuse_material;
         SingleQueue *diffuse_transmission_material;
 
+        // with a texture pool: paths whose material lookups missed a texture tile, evaluated
+        // again once it is loaded (the two queues take turns)
+        SingleQueue *texture_retry[2];
+
         uint frame_buffer_counter;
         FrameBuffer *frame_buffer_queue;
 
-        void init(GPUMemoryAllocator &allocator);
+        // (pixel, sample) keys of frame_buffer_queue, radix-sorted on device along with the
+        // entry indices so the film is written in a deterministic order
+        struct FrameBufferSort {
+            unsigned long long *keys;
+            unsigned long long *sorted_keys;
+            uint *indices;
+            uint *sorted_indices;
+
+            void *temp_storage;
+            size_t temp_storage_size;
+
+            void sort(uint num);
+        } frame_buffer_sort;
+
+        // reorders a queue by per-entry keys (radix-sorted on device), so that neighbouring
+        // threads work on similar paths
+        struct QueueSort {
+            unsigned long long *keys;
+            unsigned long long *sorted_keys;
+            uint *sorted_path_indices;
+
+            void *temp_storage;
+            size_t temp_storage_size;
+
+            void init(uint pool_size, GPUMemoryAllocator &allocator);
+
+            // keys[idx] belongs to queue->queue_array[idx], only the lowest key_bits are compared
+            void sort(SingleQueue *queue, uint key_bits);
+        } queue_sort;
+
+        void init(uint pool_size, bool texture_paging, GPUMemoryAllocator &allocator);
 
         [[nodiscard]] std::vector<SingleQueue *> get_all_queues() const {
             auto all_queues = std::vector({new_paths, rays});
@@ -125,31 +168,60 @@ class WavefrontPathIntegrator {
         }
 
       private:
-        static SingleQueue *build_new_queue(GPUMemoryAllocator &allocator);
+        static SingleQueue *build_new_queue(uint pool_size, GPUMemoryAllocator &allocator);
     };
 
-    static WavefrontPathIntegrator *create(uint samples_per_pixel, const std::string &sampler_type,
+    // without a requested size, the pool takes up to half of the free device memory but never
+    // holds more paths than the whole render needs
+    static WavefrontPathIntegrator *create(uint samples_per_pixel,
+                                           const std::pair<uint, uint> &sample_range,
+                                           const std::string &sampler_type,
                                            const ParameterDictionary &parameters,
                                            const IntegratorBase *base,
+                                           std::optional<uint> path_pool_size,
+                                           std::optional<FloatType> noise_threshold,
+                                           TexturePool *texture_pool,
                                            GPUMemoryAllocator &allocator);
 
-    void render(Film *film, bool preview);
+    // once time_limit (in seconds) is up no new samples are started, paths in flight still finish.
+    // checkpoints are written whenever the pool is drained: at the time limit and, every
+    // checkpoint interval, by letting the pool run dry before refilling it
+    void render(Film *film, std::optional<FloatType> time_limit,
+                const CheckpointOption &checkpoint_option, bool preview);
 
     PathState path_state;
 
     Queues queues;
 
     const IntegratorBase *base;
+    // nullptr when every texture is resident
+    TexturePool *texture_pool;
     uint max_depth;
     bool regularize;
     uint samples_per_pixel;
 
+    // pixels whose relative error falls below this get no more samples, 0 disables it
+    FloatType noise_threshold;
+
+    // reorder rays by origin and direction before ray_cast for more coherent traversal
+    bool sort_rays;
+    // reorder each material queue by material instance so parameter and texture loads stay
+    // coherent while shading
+    bool sort_materials;
+
+    // the light sample's contribution, to be added only if its shadow rays turn out unoccluded
     PBRT_CPU_GPU
-    SampledSpectrum sample_ld(const SurfaceInteraction &intr, const BSDF *bsdf,
-                              SampledWavelengths &lambda, Sampler *sampler) const;
+    pbrt::optional<ShadowRay> sample_ld(const SurfaceInteraction &intr, const BSDF *bsdf,
+                                        SampledWavelengths &lambda, Sampler *sampler) const;
 
+    // returns true if a shadow ray was recorded in path_state->shadow_rays[path_idx]
     PBRT_CPU_GPU
-    void sample_bsdf(uint path_idx, PathState *path_state) const;
+    bool sample_bsdf(uint path_idx, const SurfaceInteraction &isect, BSDF &bsdf,
+                     PathState *path_state) const;
 
     void evaluate_material(const Material::Type material_type);
+
+    void trace_shadow_rays();
+
+    void sort_ray_queue();
 };
@@ -6,43 +6,44 @@
 #include <pbrt/spectrum_util/global_spectra.h>
 #include <pbrt/spectrum_util/rgb_color_space.h>
 
-void DiffuseAreaLight::init(const Shape *_shape, const Transform &_render_from_light,
-                            const ParameterDictionary &parameters, GPUMemoryAllocator &allocator) {
+const AreaLightEmission *AreaLightEmission::create(const Shape *shapes,
+                                                   const ParameterDictionary &parameters,
+                                                   GPUMemoryAllocator &allocator) {
     if (parameters.has_string("filename")) {
-        throw std::runtime_error("DiffuseAreaLight::init(): this part is not implemented\n");
+        throw std::runtime_error("AreaLightEmission::create(): this part is not implemented\n");
     }
 
-    scale = parameters.get_float("scale", 1.0);
-    two_sided = parameters.get_bool("twosided", false);
+    auto emission = allocator.allocate<AreaLightEmission>();
 
-    l_emit = parameters.get_spectrum("L", SpectrumType::Illuminant, allocator);
-    if (l_emit == nullptr) {
-        l_emit = parameters.global_spectra->rgb_color_space->illuminant;
+    emission->shapes = shapes;
+    emission->scale = parameters.get_float("scale", 1.0);
+    emission->two_sided = parameters.get_bool("twosided", false);
+
+    emission->l_emit = parameters.get_spectrum("L", SpectrumType::Illuminant, allocator);
+    if (emission->l_emit == nullptr) {
+        emission->l_emit = parameters.global_spectra->rgb_color_space->illuminant;
     }
 
     const auto cie_y = parameters.global_spectra->cie_xyz[1];
-    scale /= l_emit->to_photometric(cie_y);
+    emission->scale /= emission->l_emit->to_photometric(cie_y);
 
     auto phi_v = parameters.get_float("power", -1.0);
     if (phi_v > 0.0) {
-        throw std::runtime_error("DiffuseAreaLight::init(): this part is not implemented\n");
+        throw std::runtime_error("AreaLightEmission::create(): this part is not implemented\n");
     }
 
-    light_type = LightType::area;
-    render_from_light = _render_from_light;
-
-    shape = _shape;
+    return emission;
 }
 
 PBRT_CPU_GPU
 SampledSpectrum DiffuseAreaLight::l(Point3f p, Normal3f n, Point2f uv, Vector3f w,
                                     const SampledWavelengths &lambda) const {
     // Check for zero emitted radiance from point on area light
-    if (!two_sided && n.dot(w) < 0.0) {
+    if (!emission->two_sided && n.dot(w) < 0.0) {
         return SampledSpectrum(0.0);
     }
 
-    return scale * l_emit->sample(lambda);
+    return emission->scale * emission->l_emit->sample(lambda);
 }
 
 PBRT_CPU_GPU
@@ -52,7 +53,7 @@ pbrt::optional<LightLiSample> DiffuseAreaLight::sample_li(const LightSampleConte
     // Sample point on shape for _DiffuseAreaLight_
     auto shape_ctx = ShapeSampleContext(ctx.pi, ctx.n, ctx.ns);
 
-    auto ss = shape->sample(shape_ctx, u);
+    auto ss = get_shape()->sample(shape_ctx, u);
 
     if (!ss || ss->pdf == 0 || (ss->interaction.p() - ctx.p()).squared_length() == 0) {
         return {};
@@ -73,14 +74,14 @@ FloatType DiffuseAreaLight::pdf_li(const LightSampleContext &ctx, const Vector3f
                                    bool allow_incomplete_pdf) const {
     // allow_incomplete_pdf = false
     ShapeSampleContext shapeCtx(ctx.pi, ctx.n, ctx.ns);
-    return shape->pdf(shapeCtx, wi);
+    return get_shape()->pdf(shapeCtx, wi);
 }
 
 PBRT_CPU_GPU
 pbrt::optional<LightLeSample> DiffuseAreaLight::sample_le(Point2f u1, Point2f u2,
                                                           SampledWavelengths &lambda) const {
     // Sample a point on the area light's _Shape_
-    auto ss = shape->sample(u1);
+    auto ss = get_shape()->sample(u1);
     if (!ss) {
         return {};
     }
@@ -89,7 +90,7 @@ pbrt::optional<LightLeSample> DiffuseAreaLight::sample_le(Point2f u1, Point2f u2
     Vector3f w;
     FloatType pdfDir;
 
-    if (this->two_sided) {
+    if (emission->two_sided) {
         // Choose side of surface and sample cosine-weighted outgoing direction
         if (u2[0] < 0.5f) {
             u2[0] = std::min(u2[0] * 2, OneMinusEpsilon);
@@ -123,8 +124,8 @@ pbrt::optional<LightLeSample> DiffuseAreaLight::sample_le(Point2f u1, Point2f u2
 PBRT_CPU_GPU
 void DiffuseAreaLight::pdf_le(const Interaction &intr, Vector3f w, FloatType *pdfPos,
                               FloatType *pdfDir) const {
-    *pdfPos = shape->pdf(intr);
-    *pdfDir = this->two_sided ? (cosine_hemisphere_pdf(intr.n.abs_dot(w)) / 2)
+    *pdfPos = get_shape()->pdf(intr);
+    *pdfDir = emission->two_sided ? (cosine_hemisphere_pdf(intr.n.abs_dot(w)) / 2)
                               : cosine_hemisphere_pdf(intr.n.dot(w));
 }
 
@@ -132,6 +133,6 @@ PBRT_CPU_GPU
 SampledSpectrum DiffuseAreaLight::phi(const SampledWavelengths &lambda) const {
     // TODO: image in DiffuseAreaLight is not implemented
 
-    auto L = l_emit->sample(lambda) * scale;
-    return compute_pi() * (two_sided ? 2 : 1) * this->shape->area() * L;
+    auto L = emission->l_emit->sample(lambda) * emission->scale;
+    return compute_pi() * (emission->two_sided ? 2 : 1) * area * L;
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <pbrt/base/light.h>
+#include <pbrt/base/shape.h>
 
 class GlobalSpectra;
 class GPUMemoryAllocator;
@@ -9,10 +10,32 @@ class RGBColorSpace;
 class Spectrum;
 class Shape;
 
-class DiffuseAreaLight : public LightBase {
+// emission parameters shared by every triangle (shape) of an emissive mesh
+struct AreaLightEmission {
+    const Shape *shapes;
+    bool two_sided;
+    const Spectrum *l_emit;
+    FloatType scale;
+
+    static const AreaLightEmission *create(const Shape *shapes,
+                                           const ParameterDictionary &parameters,
+                                           GPUMemoryAllocator &allocator);
+};
+
+// one per emissive shape: all but the shape index and its area live in the shared emission
+class DiffuseAreaLight {
   public:
-    void init(const Shape *_shape, const Transform &_render_from_light,
-              const ParameterDictionary &parameters, GPUMemoryAllocator &allocator);
+    PBRT_CPU_GPU
+    void init(const AreaLightEmission *_emission, uint _shape_idx) {
+        emission = _emission;
+        shape_idx = _shape_idx;
+        area = emission->shapes[shape_idx].area();
+    }
+
+    PBRT_CPU_GPU
+    LightType get_light_type() const {
+        return LightType::area;
+    }
 
     PBRT_CPU_GPU
     SampledSpectrum l(Point3f p, Normal3f n, Point2f uv, Vector3f w,
@@ -37,8 +60,12 @@ class DiffuseAreaLight : public LightBase {
     SampledSpectrum phi(const SampledWavelengths &lambda) const;
 
   private:
-    const Shape *shape;
-    bool two_sided;
-    const Spectrum *l_emit;
-    FloatType scale;
+    const AreaLightEmission *emission;
+    uint shape_idx;
+    FloatType area;
+
+    PBRT_CPU_GPU
+    const Shape *get_shape() const {
+        return &emission->shapes[shape_idx];
+    }
 };
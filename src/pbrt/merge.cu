@@ -0,0 +1,47 @@
+#include <pbrt/films/unnormalized_film.h>
+
+// combines the unnormalized films rendered over disjoint sample ranges (`--sample-range`)
+int main(int argc, const char **argv) {
+    std::vector<std::string> input_files;
+    std::string output_file;
+
+    int idx = 1;
+    while (idx < argc) {
+        const std::string argument = argv[idx];
+        if (argument == "--outfile" && idx + 1 < argc) {
+            output_file = argv[idx + 1];
+            idx += 2;
+            continue;
+        }
+
+        input_files.push_back(argument);
+        idx += 1;
+    }
+
+    if (input_files.empty() || output_file.empty()) {
+        std::cout << "please provide the films to merge and the output file:\n"
+                  << "$ pbrt-merge part-0.film part-1.film --outfile merged.png\n"
+                  << "(an output ending with `.film` is written unnormalized again)\n";
+        exit(1);
+    }
+
+    auto film = UnnormalizedFilm::read(input_files[0]);
+    for (size_t file_idx = 1; file_idx < input_files.size(); ++file_idx) {
+        film.merge(UnnormalizedFilm::read(input_files[file_idx]));
+    }
+
+    if (film.count_samples() < film.total_spp) {
+        std::cout << "merged films cover " << film.count_samples() << " of " << film.total_spp
+                  << " samples per pixel\n";
+    }
+
+    if (std::filesystem::path(output_file).extension() == ".film") {
+        film.write(output_file);
+    } else {
+        film.write_to_png(output_file);
+    }
+
+    std::cout << input_files.size() << " films merged into `" << output_file << "`\n";
+
+    return 0;
+}
@@ -11,6 +11,18 @@ struct CommandLineOption {
     std::string output_file;
     std::optional<int> samples_per_pixel;
     bool preview = false;
+    std::optional<std::string> compile_scene_file;
+    std::optional<int> texture_cache_mb;
+    std::optional<std::string> memory_report_file;
+    std::optional<double> subdivision_edge_pixels;
+    std::optional<long> subdivision_triangle_budget;
+    std::optional<uint> path_pool_size;
+    std::optional<double> noise_threshold;
+    std::optional<double> time_limit;
+    std::optional<std::string> checkpoint_file;
+    std::optional<double> checkpoint_interval;
+    std::optional<std::string> resume_file;
+    std::optional<std::pair<uint, uint>> sample_range;
 
     CommandLineOption(int argc, const char **argv) {
         int idx = 1;
@@ -35,6 +47,96 @@ struct CommandLineOption {
                     continue;
                 }
 
+                if (argument == "--compile-scene") {
+                    compile_scene_file = argv[idx + 1];
+                    idx += 2;
+                    continue;
+                }
+
+                if (argument == "--texture-cache-mb") {
+                    texture_cache_mb = stoi(std::string(argv[idx + 1]));
+                    idx += 2;
+                    continue;
+                }
+
+                if (argument == "--memory-report") {
+                    memory_report_file = argv[idx + 1];
+                    idx += 2;
+                    continue;
+                }
+
+                if (argument == "--adaptive-subdivision") {
+                    subdivision_edge_pixels = stod(std::string(argv[idx + 1]));
+                    if (!(subdivision_edge_pixels.value() > 0)) {
+                        const std::string error =
+                            "CommandLineOption(): adaptive subdivision expects a positive edge "
+                            "length in pixels: `" +
+                            std::string(argv[idx + 1]) + "`";
+                        throw std::runtime_error(error.c_str());
+                    }
+                    idx += 2;
+                    continue;
+                }
+
+                if (argument == "--subdivision-budget") {
+                    subdivision_triangle_budget = stol(std::string(argv[idx + 1]));
+                    idx += 2;
+                    continue;
+                }
+
+                if (argument == "--path-pool") {
+                    path_pool_size = stoul(std::string(argv[idx + 1]));
+                    idx += 2;
+                    continue;
+                }
+
+                if (argument == "--noise-threshold") {
+                    noise_threshold = stod(std::string(argv[idx + 1]));
+                    idx += 2;
+                    continue;
+                }
+
+                if (argument == "--time-limit") {
+                    time_limit = stod(std::string(argv[idx + 1]));
+                    idx += 2;
+                    continue;
+                }
+
+                if (argument == "--checkpoint") {
+                    checkpoint_file = argv[idx + 1];
+                    idx += 2;
+                    continue;
+                }
+
+                if (argument == "--checkpoint-interval") {
+                    checkpoint_interval = stod(std::string(argv[idx + 1]));
+                    idx += 2;
+                    continue;
+                }
+
+                if (argument == "--resume") {
+                    resume_file = argv[idx + 1];
+                    idx += 2;
+                    continue;
+                }
+
+                if (argument == "--sample-range") {
+                    // `first:last`, the last sample is excluded
+                    const std::string range = argv[idx + 1];
+                    const auto colon_idx = range.find(':');
+                    if (colon_idx == std::string::npos) {
+                        const std::string error =
+                            "CommandLineOption(): sample range should be `first:last`: `" + range +
+                            "`";
+                        throw std::runtime_error(error.c_str());
+                    }
+
+                    sample_range = {stoul(range.substr(0, colon_idx)),
+                                    stoul(range.substr(colon_idx + 1))};
+                    idx += 2;
+                    continue;
+                }
+
                 if (argument == "--outfile") {
                     output_file = argv[idx + 1];
                     idx += 2;
@@ -0,0 +1,252 @@
+#include <array>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <pbrt/scene/compiled_scene.h>
+#include <pbrt/scene/parser.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+constexpr char MAGIC[4] = {'P', 'B', 'S', 'C'};
+
+void expand_includes(const std::string &filename, const std::string &root,
+                     std::vector<Token> &output) {
+    const auto tokens = parse_pbrt_into_token(filename);
+
+    for (uint idx = 0; idx < tokens.size(); ++idx) {
+        if (tokens[idx] == Token(TokenType::Keyword, "Include")) {
+            const auto included_file = tokens[idx + 1].values[0];
+            expand_includes(root.empty() ? included_file : root + "/" + included_file, root,
+                            output);
+
+            idx += 1;
+            continue;
+        }
+
+        output.push_back(tokens[idx]);
+    }
+}
+
+std::vector<std::string> collect_ply_files(const std::vector<Token> &tokens) {
+    std::vector<std::string> ply_files;
+
+    for (uint idx = 0; idx + 1 < tokens.size(); ++idx) {
+        if (tokens[idx] != Token(TokenType::Keyword, "Shape") ||
+            tokens[idx + 1] != Token(TokenType::String, "plymesh")) {
+            continue;
+        }
+
+        // parameters run until the next directive: a variable not followed by a value is
+        // skipped rather than pairing the rest off by position
+        for (uint var_idx = idx + 2; var_idx < tokens.size(); ++var_idx) {
+            const auto &variable = tokens[var_idx];
+            if (variable.type != TokenType::Variable && variable.type != TokenType::String &&
+                variable.type != TokenType::Number && variable.type != TokenType::List) {
+                break;
+            }
+
+            if (variable.type != TokenType::Variable ||
+                variable.values != std::vector<std::string>{"string", "filename"} ||
+                var_idx + 1 >= tokens.size()) {
+                continue;
+            }
+
+            const auto &value = tokens[var_idx + 1];
+            if ((value.type == TokenType::String || value.type == TokenType::List) &&
+                !value.values.empty()) {
+                ply_files.push_back(value.values[0]);
+                break;
+            }
+        }
+    }
+
+    return ply_files;
+}
+
+class BinaryWriter {
+  public:
+    explicit BinaryWriter(const std::string &filename)
+        : stream(filename, std::ios::binary | std::ios::trunc) {
+        if (!stream.is_open()) {
+            printf("\n%s(): fail to open `%s`\n", __func__, filename.c_str());
+            REPORT_FATAL_ERROR();
+        }
+    }
+
+    template <typename T>
+    void write(const T &val) {
+        stream.write(reinterpret_cast<const char *>(&val), sizeof(T));
+    }
+
+    void write(const std::string &str) {
+        write<uint64_t>(str.size());
+        stream.write(str.data(), str.size());
+    }
+
+    template <typename T>
+    void write(const std::vector<T> &vec) {
+        write<uint64_t>(vec.size());
+        stream.write(reinterpret_cast<const char *>(vec.data()), sizeof(T) * vec.size());
+    }
+
+  private:
+    std::ofstream stream;
+};
+
+class BinaryReader {
+  public:
+    BinaryReader(const uint8_t *_data, size_t _size) : data(_data), size(_size), offset(0) {}
+
+    template <typename T>
+    T read() {
+        T val;
+        copy_to(&val, sizeof(T));
+        return val;
+    }
+
+    std::string read_string() {
+        std::string str(read<uint64_t>(), '\0');
+        copy_to(str.data(), str.size());
+        return str;
+    }
+
+    template <typename T>
+    std::vector<T> read_vector() {
+        std::vector<T> vec(read<uint64_t>());
+        copy_to(vec.data(), sizeof(T) * vec.size());
+        return vec;
+    }
+
+  private:
+    const uint8_t *data;
+    size_t size;
+    size_t offset;
+
+    void copy_to(void *dst, size_t num_bytes) {
+        if (offset + num_bytes > size) {
+            printf("\n%s(): compiled scene truncated\n", __func__);
+            REPORT_FATAL_ERROR();
+        }
+
+        memcpy(dst, data + offset, num_bytes);
+        offset += num_bytes;
+    }
+};
+} // namespace
+
+CompiledScene CompiledScene::compile(const std::string &pbrt_file) {
+    CompiledScene scene;
+    scene.root = std::filesystem::absolute(pbrt_file).parent_path().string();
+
+    expand_includes(pbrt_file, scene.root, scene.tokens);
+
+    for (const auto &ply_file : collect_ply_files(scene.tokens)) {
+        const auto file_path = scene.root + "/" + ply_file;
+        if (scene.ply_meshes.find(file_path) != scene.ply_meshes.end()) {
+            continue;
+        }
+
+        scene.ply_meshes[file_path] = TriQuadMesh::read_ply(file_path);
+    }
+
+    return scene;
+}
+
+void CompiledScene::write(const std::string &filename) const {
+    BinaryWriter writer(filename);
+
+    writer.write(MAGIC);
+    writer.write<uint32_t>(VERSION);
+    writer.write<uint32_t>(sizeof(FloatType));
+
+    writer.write(root);
+
+    writer.write<uint64_t>(tokens.size());
+    for (const auto &token : tokens) {
+        writer.write<uint32_t>(static_cast<uint32_t>(token.type));
+        writer.write<uint64_t>(token.values.size());
+        for (const auto &value : token.values) {
+            writer.write(value);
+        }
+    }
+
+    writer.write<uint64_t>(ply_meshes.size());
+    for (const auto &[file_path, mesh] : ply_meshes) {
+        writer.write(file_path);
+        writer.write(mesh.p);
+        writer.write(mesh.n);
+        writer.write(mesh.uv);
+        writer.write(mesh.faceIndices);
+        writer.write(mesh.triIndices);
+    }
+}
+
+CompiledScene CompiledScene::read(const std::string &filename) {
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        printf("\n%s(): fail to open `%s`\n", __func__, filename.c_str());
+        REPORT_FATAL_ERROR();
+    }
+
+    struct stat file_stat;
+    fstat(fd, &file_stat);
+    const size_t file_size = file_stat.st_size;
+
+    auto mapped = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (mapped == MAP_FAILED) {
+        printf("\n%s(): fail to map `%s`\n", __func__, filename.c_str());
+        REPORT_FATAL_ERROR();
+    }
+
+    BinaryReader reader(static_cast<const uint8_t *>(mapped), file_size);
+
+    const auto magic = reader.read<std::array<char, 4>>();
+    const auto version = reader.read<uint32_t>();
+    const auto float_size = reader.read<uint32_t>();
+
+    if (memcmp(magic.data(), MAGIC, sizeof(MAGIC)) != 0 || version != VERSION ||
+        float_size != sizeof(FloatType)) {
+        printf("\n%s(): `%s` is not a compatible compiled scene (version %u, %u-byte floats)\n",
+               __func__, filename.c_str(), version, float_size);
+        REPORT_FATAL_ERROR();
+    }
+
+    CompiledScene scene;
+    scene.root = reader.read_string();
+
+    const auto num_tokens = reader.read<uint64_t>();
+    scene.tokens.reserve(num_tokens);
+    for (uint64_t idx = 0; idx < num_tokens; ++idx) {
+        const auto type = static_cast<TokenType>(reader.read<uint32_t>());
+
+        std::vector<std::string> values(reader.read<uint64_t>());
+        for (auto &value : values) {
+            value = reader.read_string();
+        }
+
+        scene.tokens.emplace_back(type, values);
+    }
+
+    const auto num_meshes = reader.read<uint64_t>();
+    for (uint64_t idx = 0; idx < num_meshes; ++idx) {
+        const auto file_path = reader.read_string();
+
+        TriQuadMesh mesh;
+        mesh.p = reader.read_vector<Point3f>();
+        mesh.n = reader.read_vector<Normal3f>();
+        mesh.uv = reader.read_vector<Point2f>();
+        mesh.faceIndices = reader.read_vector<int>();
+        mesh.triIndices = reader.read_vector<int>();
+
+        scene.ply_meshes[file_path] = std::move(mesh);
+    }
+
+    munmap(mapped, file_size);
+
+    return scene;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <map>
+#include <pbrt/gpu/macro.h>
+#include <pbrt/scene/tokenizer.h>
+#include <pbrt/shapes/tri_quad_mesh.h>
+#include <string>
+#include <vector>
+
+// a pre-resolved scene: the directive stream with every `Include` expanded,
+// plus the decoded payload of every PLY file referenced by `Shape "plymesh"`.
+// only tokenizing and PLY decoding are skipped on load: shapes, subdivision, materials, lights
+// and the BVH are still built from it every time
+struct CompiledScene {
+    static constexpr uint VERSION = 2;
+
+    std::string root;
+    std::vector<Token> tokens;
+    std::map<std::string, TriQuadMesh> ply_meshes;
+
+    static CompiledScene compile(const std::string &pbrt_file);
+
+    static CompiledScene read(const std::string &filename);
+
+    void write(const std::string &filename) const;
+};
@@ -26,19 +26,14 @@ std::vector<FloatType> read_spectrum_file(const std::string &filename) {
     return values;
 }
 
-ParameterDictionary::ParameterDictionary(
-    const std::vector<Token> &tokens, const std::string &_root,
-    const GlobalSpectra *_global_spectra, const std::map<std::string, const Spectrum *> &_spectra,
-    std::map<std::string, const Material *> _materials,
-    const std::map<std::string, const FloatTexture *> &_float_textures,
-    const std::map<std::string, const SpectrumTexture *> &_albedo_spectrum_textures,
-    const std::map<std::string, const SpectrumTexture *> &_illuminant_spectrum_textures,
-    const std::map<std::string, const SpectrumTexture *> &_unbounded_spectrum_textures,
-    GPUMemoryAllocator &allocator)
-    : root(_root), global_spectra(_global_spectra), spectra(_spectra), materials(_materials),
-      float_textures(_float_textures), albedo_spectrum_textures(_albedo_spectrum_textures),
-      illuminant_spectrum_textures(_illuminant_spectrum_textures),
-      unbounded_spectrum_textures(_unbounded_spectrum_textures) {
+ParameterDictionary::ParameterDictionary(const std::vector<Token> &tokens,
+                                         const std::string &_root,
+                                         const GlobalSpectra *_global_spectra,
+                                         const SceneContext *_scene_context,
+                                         InternedObjects *_interned_objects,
+                                         GPUMemoryAllocator &allocator)
+    : root(_root), global_spectra(_global_spectra), scene_context(_scene_context),
+      interned_objects(_interned_objects) {
     // the 1st token is Keyword
     // the 2nd token is String
     // e.g. { Shape "trianglemesh" }, { Camera "perspective" }
@@ -151,9 +146,10 @@ ParameterDictionary::ParameterDictionary(
                     continue;
                 }
 
-                if (_spectra.find(spectrum_name) != _spectra.end()) {
+                if (const auto named_spectrum = scene_context->spectra.find(spectrum_name);
+                    named_spectrum != scene_context->spectra.end()) {
                     // or name of a spectrum
-                    spectra[variable_name] = _spectra.at(spectrum_name);
+                    spectra[variable_name] = named_spectrum->second;
                     continue;
                 }
 
@@ -206,8 +202,22 @@ const Spectrum *ParameterDictionary::get_spectrum(const std::string &key,
 
     if (has_rgb(key)) {
         const auto rgb_val = rgbs.at(key);
-        return Spectrum::create_from_rgb(rgb_val, spectrum_type, global_spectra->rgb_color_space,
-                                         allocator);
+        if (!interned_objects) {
+            return Spectrum::create_from_rgb(rgb_val, spectrum_type,
+                                             global_spectra->rgb_color_space, allocator);
+        }
+
+        const auto rgb_key =
+            std::make_tuple(global_spectra, rgb_val.r, rgb_val.g, rgb_val.b, spectrum_type);
+        auto &rgb_spectra = interned_objects->rgb_spectra;
+        if (const auto interned = rgb_spectra.find(rgb_key); interned != rgb_spectra.end()) {
+            return interned->second;
+        }
+
+        const auto spectrum = Spectrum::create_from_rgb(
+            rgb_val, spectrum_type, global_spectra->rgb_color_space, allocator);
+        rgb_spectra[rgb_key] = spectrum;
+        return spectrum;
     }
 
     if (blackbodies.find(key) != blackbodies.end()) {
@@ -223,7 +233,7 @@ const Spectrum *ParameterDictionary::get_spectrum(const std::string &key,
 }
 
 const Material *ParameterDictionary::get_material(const std::string &key) const {
-    return materials.at(key);
+    return scene_context->materials.at(key);
 }
 
 const FloatTexture *
@@ -232,8 +242,9 @@ ParameterDictionary::get_float_texture_or_null(const std::string &key,
     if (textures_name.find(key) != textures_name.end()) {
         const auto tex_name = textures_name.at(key);
 
-        if (float_textures.find(tex_name) != float_textures.end()) {
-            return float_textures.at(tex_name);
+        const auto &float_textures = scene_context->float_textures;
+        if (const auto texture = float_textures.find(tex_name); texture != float_textures.end()) {
+            return texture->second;
         }
 
         return nullptr;
@@ -241,7 +252,7 @@ ParameterDictionary::get_float_texture_or_null(const std::string &key,
 
     if (has_floats(key)) {
         auto val = get_float(key);
-        return FloatTexture::create_constant_float_texture(val, allocator);
+        return create_constant_float_texture(val, allocator);
     }
 
     if (DEBUG_MODE) {
@@ -259,7 +270,7 @@ const FloatTexture *ParameterDictionary::get_float_texture(const std::string &ke
         return texture;
     }
 
-    return FloatTexture::create_constant_float_texture(default_val, allocator);
+    return create_constant_float_texture(default_val, allocator);
 }
 
 const FloatTexture *ParameterDictionary::get_float_texture_with_default_val(
@@ -269,7 +280,7 @@ const FloatTexture *ParameterDictionary::get_float_texture_with_default_val(
         return texture;
     }
 
-    return FloatTexture::create_constant_float_texture(default_val, allocator);
+    return create_constant_float_texture(default_val, allocator);
 }
 
 const SpectrumTexture *
@@ -291,9 +302,10 @@ ParameterDictionary::get_spectrum_texture(const std::string &key, SpectrumType s
 
         auto &spectrumTextures =
             spectrum_type == SpectrumType::Albedo
-                ? albedo_spectrum_textures
-                : (spectrum_type == SpectrumType::Illuminant ? illuminant_spectrum_textures
-                                                             : unbounded_spectrum_textures);
+                ? scene_context->albedo_spectrum_textures
+                : (spectrum_type == SpectrumType::Illuminant
+                       ? scene_context->illuminant_spectrum_textures
+                       : scene_context->unbounded_spectrum_textures);
 
         if (spectrumTextures.find(tex_name) != spectrumTextures.end()) {
             return spectrumTextures.at(tex_name);
@@ -308,7 +320,20 @@ ParameterDictionary::get_spectrum_texture(const std::string &key, SpectrumType s
 
     const auto spectrum = get_spectrum(key, spectrum_type, allocator);
     if (spectrum) {
-        return SpectrumTexture::create_constant_texture(spectrum, allocator);
+        if (!interned_objects) {
+            return SpectrumTexture::create_constant_texture(spectrum, allocator);
+        }
+
+        const auto texture_key = std::make_pair(global_spectra, spectrum);
+        auto &constant_textures = interned_objects->constant_spectrum_textures;
+        if (const auto interned = constant_textures.find(texture_key);
+            interned != constant_textures.end()) {
+            return interned->second;
+        }
+
+        const auto texture = SpectrumTexture::create_constant_texture(spectrum, allocator);
+        constant_textures[texture_key] = texture;
+        return texture;
     }
 
     if (DEBUG_MODE) {
@@ -317,3 +342,20 @@ ParameterDictionary::get_spectrum_texture(const std::string &key, SpectrumType s
 
     return nullptr;
 }
+
+const FloatTexture *
+ParameterDictionary::create_constant_float_texture(const FloatType val,
+                                                   GPUMemoryAllocator &allocator) const {
+    if (!interned_objects) {
+        return FloatTexture::create_constant_float_texture(val, allocator);
+    }
+
+    auto &constant_textures = interned_objects->constant_float_textures;
+    if (const auto interned = constant_textures.find(val); interned != constant_textures.end()) {
+        return interned->second;
+    }
+
+    const auto texture = FloatTexture::create_constant_float_texture(val, allocator);
+    constant_textures[val] = texture;
+    return texture;
+}
@@ -9,6 +9,8 @@
 #include <pbrt/euclidean_space/point2.h>
 #include <pbrt/euclidean_space/point3.h>
 #include <pbrt/spectrum_util/rgb.h>
+#include <tuple>
+#include <unordered_map>
 #include <vector>
 
 class FloatTexture;
@@ -19,20 +21,43 @@ class Spectrum;
 class SpectrumTexture;
 class Token;
 
+// named objects declared so far by the scene description: owned by SceneBuilder and
+// shared read-only by every ParameterDictionary built from it
+struct SceneContext {
+    std::map<std::string, const Spectrum *> spectra;
+    std::map<std::string, const Material *> materials;
+
+    std::map<std::string, const FloatTexture *> float_textures;
+
+    std::map<std::string, const SpectrumTexture *> albedo_spectrum_textures;
+    std::map<std::string, const SpectrumTexture *> illuminant_spectrum_textures;
+    std::map<std::string, const SpectrumTexture *> unbounded_spectrum_textures;
+};
+
+// objects interned by content: directives with identical parameters resolve to one allocation,
+// owned by SceneBuilder and filled as ParameterDictionary (and SceneBuilder) builds them.
+// RGB values mean different spectra under different `ColorSpace`s: keys carry the active one
+struct InternedObjects {
+    std::map<std::tuple<const GlobalSpectra *, FloatType, FloatType, FloatType, SpectrumType>,
+             const Spectrum *>
+        rgb_spectra;
+    std::map<std::pair<const GlobalSpectra *, const Spectrum *>, const SpectrumTexture *>
+        constant_spectrum_textures;
+    std::map<FloatType, const FloatTexture *> constant_float_textures;
+
+    // keyed by type, root, color space and the serialized parameter tokens
+    std::unordered_map<std::string, const Material *> materials;
+};
+
 class ParameterDictionary {
   public:
     ParameterDictionary() = default;
 
-    explicit ParameterDictionary(
-        const std::vector<Token> &tokens, const std::string &_root,
-        const GlobalSpectra *_global_spectra,
-        const std::map<std::string, const Spectrum *> &_spectra,
-        std::map<std::string, const Material *> _materials,
-        const std::map<std::string, const FloatTexture *> &_float_textures,
-        const std::map<std::string, const SpectrumTexture *> &_albedo_spectrum_textures,
-        const std::map<std::string, const SpectrumTexture *> &_illuminant_spectrum_textures,
-        const std::map<std::string, const SpectrumTexture *> &_unbounded_spectrum_textures,
-        GPUMemoryAllocator &allocator);
+    explicit ParameterDictionary(const std::vector<Token> &tokens, const std::string &_root,
+                                 const GlobalSpectra *_global_spectra,
+                                 const SceneContext *_scene_context,
+                                 InternedObjects *_interned_objects,
+                                 GPUMemoryAllocator &allocator);
 
     const GlobalSpectra *global_spectra = nullptr;
 
@@ -263,24 +288,6 @@ class ParameterDictionary {
             stream << "\n";
         }
 
-        if (!parameters.albedo_spectrum_textures.empty()) {
-            stream << "albedo spectrum texture:\n";
-            parameters.print_dict_of_single_var(stream, parameters.albedo_spectrum_textures);
-            stream << "\n";
-        }
-
-        if (!parameters.illuminant_spectrum_textures.empty()) {
-            stream << "illuminant spectrum texture:\n";
-            parameters.print_dict_of_single_var(stream, parameters.illuminant_spectrum_textures);
-            stream << "\n";
-        }
-
-        if (!parameters.unbounded_spectrum_textures.empty()) {
-            stream << "unbounded spectrum texture:\n";
-            parameters.print_dict_of_single_var(stream, parameters.unbounded_spectrum_textures);
-            stream << "\n";
-        }
-
         return stream;
     }
 
@@ -300,13 +307,12 @@ class ParameterDictionary {
 
     std::map<std::string, const Spectrum *> spectra;
     std::map<std::string, std::string> textures_name;
-    std::map<std::string, const Material *> materials;
 
-    std::map<std::string, const FloatTexture *> float_textures;
+    const SceneContext *scene_context = nullptr;
+    InternedObjects *interned_objects = nullptr;
 
-    std::map<std::string, const SpectrumTexture *> unbounded_spectrum_textures;
-    std::map<std::string, const SpectrumTexture *> albedo_spectrum_textures;
-    std::map<std::string, const SpectrumTexture *> illuminant_spectrum_textures;
+    const FloatTexture *create_constant_float_texture(FloatType val,
+                                                      GPUMemoryAllocator &allocator) const;
 
     template <typename T>
     void print_dict_of_single_var(std::ostream &stream,
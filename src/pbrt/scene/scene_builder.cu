@@ -18,7 +18,9 @@
 #include <pbrt/spectrum_util/global_spectra.h>
 #include <pbrt/spectrum_util/spectrum_constants_glass.h>
 #include <pbrt/spectrum_util/spectrum_constants_metal.h>
+#include <pbrt/textures/gpu_image.h>
 #include <pbrt/textures/spectrum_constant_texture.h>
+#include <pbrt/util/hash.h>
 #include <pbrt/util/std_container.h>
 #include <set>
 
@@ -111,9 +113,25 @@ SceneBuilder::SceneBuilder(const CommandLineOption &command_line_option)
     : integrator_name(command_line_option.integrator_name),
       output_filename(command_line_option.output_file),
       samples_per_pixel(command_line_option.samples_per_pixel),
-      preview(command_line_option.preview) {
-
-    global_spectra = GlobalSpectra::create(RGBtoSpectrumData::Gamut::sRGB, allocator);
+      preview(command_line_option.preview),
+      texture_cache_mb(command_line_option.texture_cache_mb),
+      memory_report_file(command_line_option.memory_report_file),
+      subdivision_edge_pixels(command_line_option.subdivision_edge_pixels),
+      subdivision_triangle_budget(command_line_option.subdivision_triangle_budget),
+      path_pool_size(command_line_option.path_pool_size),
+      noise_threshold(command_line_option.noise_threshold),
+      time_limit(command_line_option.time_limit),
+      sample_range(command_line_option.sample_range) {
+    checkpoint_option.checkpoint_file = command_line_option.checkpoint_file;
+    checkpoint_option.resume_file = command_line_option.resume_file;
+    if (command_line_option.checkpoint_interval.has_value()) {
+        checkpoint_option.interval = command_line_option.checkpoint_interval.value();
+    }
+
+    GPUMemoryAllocator::Scope memory_scope(MemoryCategory::Spectrum);
+
+    graphics_state.global_spectra = get_global_spectra(RGBtoSpectrumData::Gamut::sRGB);
+    film_global_spectra = graphics_state.global_spectra;
 
     auto ag_eta = Spectrum::create_piecewise_linear_spectrum_from_interleaved(Ag_eta, false,
                                                                               nullptr, allocator);
@@ -142,7 +160,7 @@ SceneBuilder::SceneBuilder(const CommandLineOption &command_line_option)
     auto glass_bk7_eta = Spectrum::create_piecewise_linear_spectrum_from_interleaved(
         GlassBK7_eta, false, nullptr, allocator);
 
-    spectra = {
+    scene_context.spectra = {
         {"metal-Ag-eta", ag_eta},     {"metal-Ag-k", ag_k},     {"metal-Al-eta", al_eta},
         {"metal-Al-k", al_k},         {"metal-Au-eta", au_eta}, {"metal-Au-k", au_k},
         {"metal-Cu-eta", cu_eta},     {"metal-Cu-k", cu_k},
@@ -153,6 +171,7 @@ SceneBuilder::SceneBuilder(const CommandLineOption &command_line_option)
     integrator_base = allocator.allocate<IntegratorBase>();
     integrator_base->init();
 
+    GPUMemoryAllocator::Scope material_memory_scope(MemoryCategory::Material);
     auto texture = SpectrumTexture::create_constant_float_val_texture(0.5, allocator);
     graphics_state.material = Material::create_diffuse_material(texture, allocator);
 }
@@ -202,8 +221,24 @@ void SceneBuilder::build_filter() {
     integrator_base->filter = Filter::create(filter_type, parameters, allocator);
 }
 
+const GlobalSpectra *SceneBuilder::get_global_spectra(const RGBtoSpectrumData::Gamut gamut) {
+    if (const auto it = global_spectra_by_gamut.find(gamut); it != global_spectra_by_gamut.end()) {
+        return it->second;
+    }
+
+    GPUMemoryAllocator::Scope memory_scope(MemoryCategory::Spectrum);
+
+    const auto global_spectra = GlobalSpectra::create(gamut, allocator);
+    global_spectra_by_gamut[gamut] = global_spectra;
+
+    return global_spectra;
+}
+
 void SceneBuilder::build_film() {
-    const auto parameters = build_parameter_dictionary(sub_vector(film_tokens, 2));
+    // the film converts sensor RGB into the color space declared along with it
+    const auto parameters =
+        ParameterDictionary(sub_vector(film_tokens, 2), root, film_global_spectra, &scene_context,
+                            &interned_objects, allocator);
 
     if (output_filename.empty()) {
         output_filename = parameters.get_one_string("filename");
@@ -217,10 +252,14 @@ void SceneBuilder::build_film() {
     if (integrator_base->filter == nullptr) {
         REPORT_FATAL_ERROR();
     }
+
+    GPUMemoryAllocator::Scope memory_scope(MemoryCategory::Film);
     film = Film::create_rgb_film(integrator_base->filter, parameters, allocator);
 }
 
 void SceneBuilder::build_gpu_lights() {
+    GPUMemoryAllocator::Scope memory_scope(MemoryCategory::Light);
+
     auto light_array = allocator.allocate<const Light *>(gpu_lights.size());
     CHECK_CUDA_ERROR(cudaMemcpy(light_array, gpu_lights.data(), sizeof(Light *) * gpu_lights.size(),
                                 cudaMemcpyHostToDevice));
@@ -247,9 +286,58 @@ void SceneBuilder::build_gpu_lights() {
     integrator_base->infinite_light_num = infinite_lights.size();
 }
 
+std::pair<uint, uint> SceneBuilder::get_sample_range() const {
+    const uint spp = samples_per_pixel.value();
+    if (!sample_range.has_value()) {
+        return {0, spp};
+    }
+
+    const auto [first, last] = sample_range.value();
+    if (first >= last || last > spp) {
+        printf("\n%s(): invalid sample range %u:%u for %u samples per pixel\n", __func__, first,
+               last, spp);
+        REPORT_FATAL_ERROR();
+    }
+
+    // the .film records [first, last) as fully rendered: pbrt-merge would overstate a render cut
+    // short, and refuse the follow-up range covering the samples never taken
+    if (time_limit.has_value() || noise_threshold.has_value()) {
+        printf("\n%s(): sample range can't be combined with --time-limit or --noise-threshold\n",
+               __func__);
+        REPORT_FATAL_ERROR();
+    }
+
+    return sample_range.value();
+}
+
+void SceneBuilder::enable_texture_paging() {
+    if (!texture_cache_mb.has_value()) {
+        return;
+    }
+
+    if (texture_cache_mb.value() <= 0) {
+        printf("\n%s(): texture cache must be positive (got %d MB)\n", __func__,
+               texture_cache_mb.value());
+        REPORT_FATAL_ERROR();
+    }
+
+    // only the wavefront path integrator runs a lookup again once its tile is loaded
+    const auto name = integrator_name.value_or("path");
+    if (name != "path" && name != "volpath") {
+        printf("texture cache: not supported by integrator `%s`, textures stay resident\n",
+               name.c_str());
+        return;
+    }
+
+    texture_paging = true;
+    GPUImage::enable_paging();
+}
+
 void SceneBuilder::build_integrator() {
     build_gpu_lights();
 
+    GPUMemoryAllocator::Scope memory_scope(MemoryCategory::PathState);
+
     const auto parameters = build_parameter_dictionary(sub_vector(integrator_tokens, 2));
 
     if (!integrator_name.has_value()) {
@@ -280,6 +368,12 @@ void SceneBuilder::build_integrator() {
     }
 
     if (integrator_name == "mlt" || integrator_name == "mltpath") {
+        if (sample_range.has_value()) {
+            // markov chains don't map to (pixel, sample) indices
+            printf("\n%s(): sample range is not supported by MLT\n", __func__);
+            REPORT_FATAL_ERROR();
+        }
+
         mlt_integrator = MLTPathIntegrator::create(samples_per_pixel.value(), parameters,
                                                    integrator_base, allocator);
         return;
@@ -288,8 +382,11 @@ void SceneBuilder::build_integrator() {
     printf("sampler: %s\n", sampler_type.c_str());
 
     if (integrator_name == "path") {
-        wavefront_path_integrator = WavefrontPathIntegrator::create(
-            samples_per_pixel.value(), sampler_type, parameters, integrator_base, allocator);
+        wavefront_path_integrator =
+            WavefrontPathIntegrator::create(samples_per_pixel.value(), get_sample_range(),
+                                            sampler_type, parameters, integrator_base,
+                                            path_pool_size, noise_threshold, texture_pool,
+                                            allocator);
         return;
     }
 
@@ -314,6 +411,26 @@ void SceneBuilder::parse_keyword(const std::vector<Token> &tokens) {
         return;
     }
 
+    if (keyword == "ColorSpace") {
+        static const std::map<std::string, RGBtoSpectrumData::Gamut> gamuts = {
+            {"srgb", RGBtoSpectrumData::Gamut::sRGB},
+            {"rec2020", RGBtoSpectrumData::Gamut::REC2020},
+            {"aces2065-1", RGBtoSpectrumData::Gamut::ACES2065_1},
+            {"dci-p3", RGBtoSpectrumData::Gamut::DCI_P3},
+            {"prophoto-rgb", RGBtoSpectrumData::Gamut::ProPhotoRGB},
+            {"ergb", RGBtoSpectrumData::Gamut::ERGB},
+        };
+
+        const auto name = tokens[1].values[0];
+        if (gamuts.find(name) == gamuts.end()) {
+            printf("\n%s(): color space `%s` not implemented\n", __func__, name.c_str());
+            REPORT_FATAL_ERROR();
+        }
+
+        graphics_state.global_spectra = get_global_spectra(gamuts.at(name));
+        return;
+    }
+
     if (keyword == "ConcatTransform") {
         parse_concat_transform(tokens);
         return;
@@ -332,6 +449,7 @@ void SceneBuilder::parse_keyword(const std::vector<Token> &tokens) {
 
     if (keyword == "Film") {
         film_tokens = tokens;
+        film_global_spectra = graphics_state.global_spectra;
         return;
     }
 
@@ -474,6 +592,7 @@ void SceneBuilder::parse_light_source(const std::vector<Token> &tokens) {
 
     const auto light_source_type = tokens[1].values[0];
 
+    GPUMemoryAllocator::Scope memory_scope(MemoryCategory::Light);
     auto light = Light::create(light_source_type, get_render_from_object(), parameters, allocator);
     gpu_lights.push_back(light);
 }
@@ -495,6 +614,33 @@ void SceneBuilder::parse_lookat(const std::vector<Token> &tokens) {
     graphics_state.transform = graphics_state.transform * Transform::lookat(position, look, up);
 }
 
+const Material *SceneBuilder::create_material(const std::string &type_of_material,
+                                              const std::vector<Token> &parameter_tokens) {
+    // the same RGB parameters are another material under another color space
+    std::string key =
+        type_of_material + "\n" + root + "\n" +
+        std::to_string(reinterpret_cast<uintptr_t>(graphics_state.global_spectra));
+    for (const auto &token : parameter_tokens) {
+        key += "\n" + std::to_string(static_cast<int>(token.type));
+        for (const auto &value : token.values) {
+            key += " " + std::to_string(value.size()) + ":" + value;
+        }
+    }
+
+    auto &materials = interned_objects.materials;
+    if (const auto interned = materials.find(key); interned != materials.end()) {
+        return interned->second;
+    }
+
+    const auto parameters = build_parameter_dictionary(parameter_tokens);
+
+    GPUMemoryAllocator::Scope memory_scope(MemoryCategory::Material);
+    const auto material = Material::create(type_of_material, parameters, allocator);
+
+    materials[key] = material;
+    return material;
+}
+
 void SceneBuilder::parse_make_named_material(const std::vector<Token> &tokens) {
     if (tokens[0] != Token(TokenType::Keyword, "MakeNamedMaterial")) {
         REPORT_FATAL_ERROR();
@@ -502,11 +648,27 @@ void SceneBuilder::parse_make_named_material(const std::vector<Token> &tokens) {
 
     const auto material_name = tokens[1].values[0];
 
-    const auto parameters = build_parameter_dictionary(sub_vector(tokens, 2));
+    const auto parameter_tokens = sub_vector(tokens, 2);
+
+    // read `string type` straight from the tokens: the dictionary is only built on a cache miss
+    std::string type_of_material;
+    for (uint idx = 0; idx + 1 < parameter_tokens.size(); idx += 2) {
+        if (parameter_tokens[idx].values == std::vector<std::string>{"string", "type"}) {
+            type_of_material = parameter_tokens[idx + 1].values[0];
+        }
+    }
+    if (type_of_material.empty()) {
+        printf("\n%s(): material `%s` has no type\n", __func__, material_name.c_str());
+        REPORT_FATAL_ERROR();
+    }
 
-    auto type_of_material = parameters.get_one_string("type");
+    const auto material = create_material(type_of_material, parameter_tokens);
 
-    materials[material_name] = Material::create(type_of_material, parameters, allocator);
+    if (scene_context.materials.find(material_name) != scene_context.materials.end()) {
+        // cached (mix) materials may refer to the redefined name
+        interned_objects.materials.clear();
+    }
+    scene_context.materials[material_name] = material;
 }
 
 void SceneBuilder::parse_material(const std::vector<Token> &tokens) {
@@ -516,9 +678,7 @@ void SceneBuilder::parse_material(const std::vector<Token> &tokens) {
 
     auto type_of_material = tokens[1].values[0];
 
-    const auto parameters = build_parameter_dictionary(sub_vector(tokens, 2));
-
-    graphics_state.material = Material::create(type_of_material, parameters, allocator);
+    graphics_state.material = create_material(type_of_material, sub_vector(tokens, 2));
 }
 
 void SceneBuilder::parse_named_material(const std::vector<Token> &tokens) {
@@ -528,11 +688,11 @@ void SceneBuilder::parse_named_material(const std::vector<Token> &tokens) {
 
     const auto material_name = tokens[1].values[0];
 
-    if (materials.find(material_name) == materials.end()) {
+    if (scene_context.materials.find(material_name) == scene_context.materials.end()) {
         REPORT_FATAL_ERROR();
     }
 
-    graphics_state.material = materials.at(material_name);
+    graphics_state.material = scene_context.materials.at(material_name);
 }
 
 void SceneBuilder::parse_rotate(const std::vector<Token> &tokens) {
@@ -584,8 +744,29 @@ void SceneBuilder::parse_shape(const std::vector<Token> &tokens) {
     auto type_of_shape = tokens[1].values[0];
     const auto render_from_object = get_render_from_object();
 
-    auto result = Shape::create(type_of_shape, render_from_object, render_from_object.inverse(),
-                                graphics_state.reverse_orientation, parameters, allocator);
+    GPUMemoryAllocator::Scope memory_scope(MemoryCategory::Mesh);
+
+    std::pair<const Shape *, uint> result;
+    if (type_of_shape == "plymesh") {
+        result = build_shared_ply_mesh(parameters.root + "/" +
+                                           parameters.get_one_string("filename"),
+                                       render_from_object);
+
+    } else if (type_of_shape == "loopsubdiv" && !active_instance_definition &&
+               (subdivision_edge_pixels.has_value() || subdivision_triangle_budget.has_value())) {
+        const auto indices = parameters.get_integers("indices");
+        const auto points = parameters.get_point3_array("P");
+        const auto levels = select_subdivision_level(parameters.get_integer("levels", 3), indices,
+                                                     points, render_from_object);
+
+        result = Shape::create_loop_subdivision(levels, indices, points, render_from_object,
+                                                graphics_state.reverse_orientation, allocator);
+
+    } else {
+        result = Shape::create(type_of_shape, render_from_object, render_from_object.inverse(),
+                               graphics_state.reverse_orientation, parameters, allocator);
+    }
+
     auto shapes = result.first;
     auto num_shapes = result.second;
 
@@ -610,9 +791,12 @@ void SceneBuilder::parse_shape(const std::vector<Token> &tokens) {
         REPORT_FATAL_ERROR();
     }
 
-    auto diffuse_area_lights =
-        Light::create_diffuse_area_lights(shapes, num_shapes, render_from_object,
-                                          graphics_state.area_light_entity->parameters, allocator);
+    Light *diffuse_area_lights = nullptr;
+    {
+        GPUMemoryAllocator::Scope light_memory_scope(MemoryCategory::Light);
+        diffuse_area_lights = Light::create_diffuse_area_lights(
+            shapes, num_shapes, graphics_state.area_light_entity->parameters, allocator);
+    }
 
     auto geometric_primitives = Primitive::create_geometric_primitives(
         shapes, graphics_state.material, diffuse_area_lights, num_shapes, allocator);
@@ -627,32 +811,144 @@ void SceneBuilder::parse_shape(const std::vector<Token> &tokens) {
     }
 }
 
+std::pair<const Shape *, uint>
+SceneBuilder::build_shared_ply_mesh(const std::string &file_path,
+                                    const Transform &render_from_object) {
+    auto shared_it = shared_ply_meshes.find(file_path);
+    if (shared_it == shared_ply_meshes.end()) {
+        SharedPlyMesh shared_ply_mesh;
+        if (const auto preloaded = ply_meshes.find(file_path); preloaded != ply_meshes.end()) {
+            shared_ply_mesh.ply_mesh = std::move(preloaded->second);
+            ply_meshes.erase(preloaded);
+        } else {
+            shared_ply_mesh.ply_mesh = TriQuadMesh::read_ply(file_path);
+        }
+
+        if (!shared_ply_mesh.ply_mesh.triIndices.empty()) {
+            shared_ply_mesh.shared_buffers = TriangleMesh::upload_shared_buffers(
+                shared_ply_mesh.ply_mesh.triIndices, shared_ply_mesh.ply_mesh.uv, allocator);
+        }
+
+        shared_it = shared_ply_meshes.emplace(file_path, std::move(shared_ply_mesh)).first;
+    }
+
+    auto &shared_ply_mesh = shared_it->second;
+    if (shared_ply_mesh.ply_mesh.triIndices.empty()) {
+        return {nullptr, 0};
+    }
+
+    std::pair<std::array<FloatType, 16>, bool> key;
+    for (uint y = 0; y < 4; ++y) {
+        for (uint x = 0; x < 4; ++x) {
+            key.first[y * 4 + x] = render_from_object.get_matrix()[y][x];
+        }
+    }
+    key.second = graphics_state.reverse_orientation;
+
+    if (const auto built = shared_ply_mesh.built_shapes.find(key);
+        built != shared_ply_mesh.built_shapes.end()) {
+        return built->second;
+    }
+
+    const auto result = TriangleMesh::build_triangles(
+        render_from_object, graphics_state.reverse_orientation, shared_ply_mesh.ply_mesh.p,
+        shared_ply_mesh.ply_mesh.n, shared_ply_mesh.shared_buffers, allocator);
+
+    shared_ply_mesh.built_shapes[key] = result;
+    return result;
+}
+
+int SceneBuilder::select_subdivision_level(const int max_levels, const std::vector<int> &indices,
+                                           const std::vector<Point3f> &points,
+                                           const Transform &render_from_object) const {
+    const long num_faces = indices.size() / 3;
+    if (num_faces == 0) {
+        return 0;
+    }
+
+    int level = max_levels;
+
+    const auto camera_base = integrator_base->camera->get_camerabase();
+
+    // pixel size is left at 0 by cameras that don't project through a screen window
+    if (subdivision_edge_pixels.has_value() && camera_base->pixel_size_at_unit_distance > 0) {
+        // every level halves the edges: stop once the mean edge, measured at the point of the
+        // mesh closest to the camera, projects to fewer than the target pixels
+        const auto camera_position =
+            camera_base->camera_transform.render_from_camera(Point3f(0, 0, 0));
+
+        Bounds3f bounds;
+        for (const auto &p : points) {
+            bounds += render_from_object(p);
+        }
+
+        FloatType sum_edge_length = 0;
+        for (long face = 0; face < num_faces; ++face) {
+            for (int k = 0; k < 3; ++k) {
+                const auto p0 = render_from_object(points[indices[face * 3 + k]]);
+                const auto p1 = render_from_object(points[indices[face * 3 + (k + 1) % 3]]);
+                sum_edge_length += (p1 - p0).length();
+            }
+        }
+
+        const Point3f nearest(clamp(camera_position.x, bounds.p_min.x, bounds.p_max.x),
+                              clamp(camera_position.y, bounds.p_min.y, bounds.p_max.y),
+                              clamp(camera_position.z, bounds.p_min.z, bounds.p_max.z));
+        const FloatType distance = (camera_position - nearest).length();
+        const FloatType edge_pixels = sum_edge_length / (num_faces * 3) /
+                                      (distance * camera_base->pixel_size_at_unit_distance);
+
+        if (distance > 0 && edge_pixels <= subdivision_edge_pixels.value()) {
+            level = 0;
+        } else if (distance > 0) {
+            level = std::min<int>(
+                level, std::ceil(std::log2(edge_pixels / subdivision_edge_pixels.value())));
+        }
+    }
+
+    if (subdivision_triangle_budget.has_value()) {
+        // each level quadruples the triangle count
+        while (level > 0 && (num_faces << (2 * level)) > subdivision_triangle_budget.value()) {
+            level -= 1;
+        }
+    }
+
+    return level;
+}
+
 void SceneBuilder::parse_texture(const std::vector<Token> &tokens) {
     auto texture_name = tokens[1].values[0];
     auto color_type = tokens[2].values[0];
     auto texture_type = tokens[3].values[0];
     const auto parameters = build_parameter_dictionary(sub_vector(tokens, 4));
 
+    GPUMemoryAllocator::Scope memory_scope(MemoryCategory::Texture);
+
+    // cached materials may refer to a texture of this name
+    interned_objects.materials.clear();
+
     if (color_type == "float") {
         auto float_texture =
             FloatTexture::create(texture_type, get_render_from_object(), parameters, allocator);
-        float_textures[texture_name] = float_texture;
+        scene_context.float_textures[texture_name] = float_texture;
 
         return;
     }
 
     if (color_type == "spectrum") {
-        albedo_spectrum_textures[texture_name] =
+        const auto rgb_color_space = graphics_state.global_spectra->rgb_color_space;
+
+        scene_context.albedo_spectrum_textures[texture_name] =
             SpectrumTexture::create(texture_type, SpectrumType::Albedo, get_render_from_object(),
-                                    global_spectra->rgb_color_space, parameters, allocator);
+                                    rgb_color_space, parameters, allocator);
 
-        illuminant_spectrum_textures[texture_name] = SpectrumTexture::create(
-            texture_type, SpectrumType::Illuminant, get_render_from_object(),
-            global_spectra->rgb_color_space, parameters, allocator);
+        scene_context.illuminant_spectrum_textures[texture_name] =
+            SpectrumTexture::create(texture_type, SpectrumType::Illuminant,
+                                    get_render_from_object(), rgb_color_space, parameters, allocator);
 
-        unbounded_spectrum_textures[texture_name] =
+        scene_context.unbounded_spectrum_textures[texture_name] =
             SpectrumTexture::create(texture_type, SpectrumType::Unbounded, get_render_from_object(),
-                                    global_spectra->rgb_color_space, parameters, allocator);
+                                    rgb_color_space, parameters, allocator);
 
         return;
     }
@@ -693,6 +989,17 @@ void SceneBuilder::parse_translate(const std::vector<Token> &tokens) {
 }
 
 void SceneBuilder::parse_tokens(const std::vector<Token> &tokens) {
+    // included files are hashed as their `Include` is parsed
+    for (const auto &token : tokens) {
+        const auto type = static_cast<int>(token.type);
+        scene_hash = HIDDEN::MurmurHash64A(reinterpret_cast<const unsigned char *>(&type),
+                                           sizeof(type), scene_hash);
+        for (const auto &value : token.values) {
+            scene_hash = HIDDEN::MurmurHash64A(reinterpret_cast<const unsigned char *>(value.data()),
+                                               value.size(), scene_hash);
+        }
+    }
+
     uint token_idx = 0;
     while (token_idx < tokens.size()) {
         const Token &first_token = tokens[token_idx];
@@ -700,6 +1007,7 @@ void SceneBuilder::parse_tokens(const std::vector<Token> &tokens) {
             build_filter();
             build_film();
             build_camera();
+            enable_texture_paging();
 
             graphics_state.transform = Transform::identity();
             named_coordinate_systems["world"] = graphics_state.transform;
@@ -815,6 +1123,17 @@ void SceneBuilder::parse_file(const std::string &_filename) {
 }
 
 void SceneBuilder::preprocess() {
+    // parsing is done: no reference is left to build from the host copies of the PLY meshes,
+    // only their device buffers are still in use
+    shared_ply_meshes.clear();
+    ply_meshes.clear();
+
+    if (texture_paging) {
+        GPUMemoryAllocator::Scope memory_scope(MemoryCategory::Texture);
+        texture_pool = GPUImage::build_texture_pool(
+            size_t(texture_cache_mb.value()) * 1024 * 1024, allocator);
+    }
+
     integrator_base->bvh = HLBVH::create(gpu_primitives, allocator);
 
     const auto full_scene_bounds = integrator_base->bvh->bounds();
@@ -824,6 +1143,18 @@ void SceneBuilder::preprocess() {
 
     build_integrator();
 
+    // a checkpoint only resumes the render it was written for
+    const auto [first_sample_idx, last_sample_idx] = get_sample_range();
+    const std::string render_options =
+        integrator_name.value() + " spp " + std::to_string(samples_per_pixel.value()) +
+        " range " + std::to_string(first_sample_idx) + ":" + std::to_string(last_sample_idx) +
+        " noise " + std::to_string(noise_threshold.value_or(0)) + " subdivision " +
+        std::to_string(subdivision_edge_pixels.value_or(0)) + " " +
+        std::to_string(subdivision_triangle_budget.value_or(0));
+    checkpoint_option.render_hash =
+        HIDDEN::MurmurHash64A(reinterpret_cast<const unsigned char *>(render_options.data()),
+                              render_options.size(), scene_hash);
+
     if (bdpt_integrator != nullptr) {
         printf("Integrator: (wavefront) bdpt\n");
     } else if (mlt_integrator != nullptr) {
@@ -855,6 +1186,11 @@ void SceneBuilder::preprocess() {
                double(kv.second) / primitives_size * 100);
     }
     printf("\n");
+
+    GPUMemoryAllocator::print_memory_usage();
+    if (memory_report_file.has_value()) {
+        GPUMemoryAllocator::write_memory_usage_json(memory_report_file.value());
+    }
 }
 
 void SceneBuilder::render() const {
@@ -881,16 +1217,30 @@ void SceneBuilder::render() const {
 
     const auto spp = samples_per_pixel.value();
 
+    // with a sample range the raw accumulators are written for pbrt-merge instead of an image
+    const auto output_file =
+        sample_range.has_value()
+            ? std::filesystem::path(output_filename).replace_extension(".film").string()
+            : output_filename;
+
+    const auto write_film = [&](const FloatType splat_scale) {
+        if (sample_range.has_value()) {
+            film->write_unnormalized(output_file, splat_scale > 0 ? 1 / splat_scale : 0,
+                                     get_sample_range(), samples_per_pixel.value());
+        } else {
+            film->write_to_png(output_file, splat_scale);
+        }
+    };
+
     if (bdpt_integrator != nullptr) {
         std::cout << " (samples per pixel: " << spp << ")"
                   << " with BDPT\n"
                   << std::flush;
 
-        auto splat_scale = 1.0 / spp;
-
-        bdpt_integrator->render(film, spp, preview);
+        const auto splat_scale = bdpt_integrator->render(film, spp, get_sample_range(), time_limit,
+                                                         checkpoint_option, preview);
 
-        film->write_to_png(output_filename, splat_scale);
+        write_film(splat_scale);
 
     } else if (mlt_integrator != nullptr) {
         std::cout << " (mutations per pixel: " << spp << ")"
@@ -899,9 +1249,10 @@ void SceneBuilder::render() const {
 
         GreyScaleFilm heatmap(film_resolution);
 
-        const auto brightness = mlt_integrator->render(film, heatmap, spp, preview);
+        const auto splat_scale =
+            mlt_integrator->render(film, heatmap, spp, time_limit, checkpoint_option, preview);
 
-        film->write_to_png(output_filename, brightness / spp);
+        film->write_to_png(output_filename, splat_scale);
 
         heatmap.write_to_png("heatmap-" + output_filename);
 
@@ -910,19 +1261,31 @@ void SceneBuilder::render() const {
                   << " with wavefront-path\n"
                   << std::flush;
 
-        wavefront_path_integrator->render(film, preview);
+        wavefront_path_integrator->render(film, time_limit, checkpoint_option, preview);
 
-        film->write_to_png(output_filename);
+        write_film(1);
 
     } else if (megakernel_integrator != nullptr) {
         std::cout << " (samples per pixel: " << spp << ")"
                   << " with " + megakernel_integrator->get_name() << "\n"
                   << std::flush;
 
+        if (time_limit.has_value()) {
+            printf("time limit ignored: not supported by %s\n",
+                   megakernel_integrator->get_name().c_str());
+        }
+
+        if (checkpoint_option.checkpoint_file.has_value() ||
+            checkpoint_option.resume_file.has_value()) {
+            printf("checkpoint ignored: not supported by %s\n",
+                   megakernel_integrator->get_name().c_str());
+        }
+
         megakernel_integrator->render(film, sampler_type, samples_per_pixel.value(),
-                                      integrator_base, preview);
+                                      get_sample_range(), noise_threshold, integrator_base,
+                                      preview);
 
-        film->write_to_png(output_filename);
+        write_film(1);
 
     } else {
         REPORT_FATAL_ERROR();
@@ -936,5 +1299,11 @@ void SceneBuilder::render() const {
 
     printf("GPU memory used: %s\n", allocator.get_allocated_memory_size().c_str());
 
-    std::cout << "image saved to `" << output_filename << "`\n";
+    // integrators allocate their path state inside render(): report again to cover its peak
+    GPUMemoryAllocator::print_memory_usage();
+    if (memory_report_file.has_value()) {
+        GPUMemoryAllocator::write_memory_usage_json(memory_report_file.value());
+    }
+
+    std::cout << "image saved to `" << output_file << "`\n";
 }
@@ -4,8 +4,13 @@
 #include <pbrt/euclidean_space/transform.h>
 #include <pbrt/gpu/gpu_memory_allocator.h>
 #include <pbrt/scene/command_line_option.h>
+#include <pbrt/scene/compiled_scene.h>
 #include <pbrt/scene/parameter_dictionary.h>
 #include <pbrt/scene/parser.h>
+#include <pbrt/shapes/triangle_mesh.h>
+#include <pbrt/spectrum_util/rgb_to_spectrum_data.h>
+#include <pbrt/util/checkpoint.h>
+#include <array>
 #include <filesystem>
 #include <map>
 #include <stack>
@@ -17,6 +22,7 @@ class MegakernelIntegrator;
 class MLTPathIntegrator;
 class Primitive;
 class Renderer;
+class TexturePool;
 class WavefrontPathIntegrator;
 struct IntegratorBase;
 
@@ -36,6 +42,9 @@ class GraphicsState {
     Transform transform;
     const Material *material = nullptr;
 
+    // RGB values are interpreted in the last declared `ColorSpace`
+    const GlobalSpectra *global_spectra = nullptr;
+
     std::optional<AreaLightEntity> area_light_entity;
 };
 
@@ -58,6 +67,20 @@ class SceneBuilder {
     std::optional<int> samples_per_pixel;
     std::optional<std::string> integrator_name;
     bool preview = false;
+    // device memory for decoded texture tiles, see TexturePool
+    std::optional<int> texture_cache_mb;
+    bool texture_paging = false;
+    TexturePool *texture_pool = nullptr;
+    std::optional<std::string> memory_report_file;
+    std::optional<double> subdivision_edge_pixels;
+    std::optional<long> subdivision_triangle_budget;
+    std::optional<uint> path_pool_size;
+    std::optional<FloatType> noise_threshold;
+    std::optional<FloatType> time_limit;
+    CheckpointOption checkpoint_option;
+    // every parsed token is folded in, see CheckpointOption::render_hash
+    uint64_t scene_hash = 0;
+    std::optional<std::pair<uint, uint>> sample_range;
 
     const MegakernelIntegrator *megakernel_integrator = nullptr;
     WavefrontPathIntegrator *wavefront_path_integrator = nullptr;
@@ -68,18 +91,15 @@ class SceneBuilder {
 
     Film *film = nullptr;
 
-    const GlobalSpectra *global_spectra = nullptr;
+    // built on first use: a scene usually only declares one color space
+    std::map<RGBtoSpectrumData::Gamut, const GlobalSpectra *> global_spectra_by_gamut;
+    // the color space in effect where `Film` is declared
+    const GlobalSpectra *film_global_spectra = nullptr;
 
     GPUMemoryAllocator allocator;
 
-    std::map<std::string, const Material *> materials;
-    std::map<std::string, const Spectrum *> spectra;
-
-    std::map<std::string, const FloatTexture *> float_textures;
-
-    std::map<std::string, const SpectrumTexture *> albedo_spectrum_textures;
-    std::map<std::string, const SpectrumTexture *> illuminant_spectrum_textures;
-    std::map<std::string, const SpectrumTexture *> unbounded_spectrum_textures;
+    SceneContext scene_context;
+    InternedObjects interned_objects;
 
     std::string output_filename;
 
@@ -114,25 +134,46 @@ class SceneBuilder {
 
     std::map<std::string, std::shared_ptr<ActiveInstanceDefinition>> instance_definition;
 
+    // PLY payloads preloaded from a compiled scene, keyed by full path
+    std::map<std::string, TriQuadMesh> ply_meshes;
+
+    // every `Shape "plymesh"` reference to the same file reads it only once and shares its
+    // indices and uv; references under an identical transform share the whole triangle array.
+    // the host copies are kept until parsing finishes (see preprocess())
+    struct SharedPlyMesh {
+        TriQuadMesh ply_mesh;
+        TriangleMesh::SharedBuffers shared_buffers;
+        std::map<std::pair<std::array<FloatType, 16>, bool>, std::pair<const Shape *, uint>>
+            built_shapes;
+    };
+
+    std::map<std::string, SharedPlyMesh> shared_ply_meshes;
+
   public:
     explicit SceneBuilder(const CommandLineOption &command_line_option);
 
     ParameterDictionary build_parameter_dictionary(const std::vector<Token> &tokens) {
-        return ParameterDictionary(tokens, root, global_spectra, spectra, materials, float_textures,
-                                   albedo_spectrum_textures, illuminant_spectrum_textures,
-                                   unbounded_spectrum_textures, allocator);
+        return ParameterDictionary(tokens, root, graphics_state.global_spectra, &scene_context,
+                                   &interned_objects, allocator);
     }
 
+    const GlobalSpectra *get_global_spectra(RGBtoSpectrumData::Gamut gamut);
+
     void build_camera();
 
     void build_filter();
 
     void build_film();
 
+    void enable_texture_paging();
+
     void build_gpu_lights();
 
     void build_integrator();
 
+    // [first, last) samples of each pixel to render, all of them by default
+    std::pair<uint, uint> get_sample_range() const;
+
     void parse_keyword(const std::vector<Token> &tokens);
 
     void parse_area_light_source(const std::vector<Token> &tokens);
@@ -143,6 +184,9 @@ class SceneBuilder {
 
     void parse_lookat(const std::vector<Token> &tokens);
 
+    const Material *create_material(const std::string &type_of_material,
+                                    const std::vector<Token> &parameter_tokens);
+
     void parse_make_named_material(const std::vector<Token> &tokens);
 
     void parse_material(const std::vector<Token> &tokens);
@@ -155,6 +199,13 @@ class SceneBuilder {
 
     void parse_shape(const std::vector<Token> &tokens);
 
+    std::pair<const Shape *, uint> build_shared_ply_mesh(const std::string &file_path,
+                                                         const Transform &render_from_object);
+
+    int select_subdivision_level(int max_levels, const std::vector<int> &indices,
+                                 const std::vector<Point3f> &points,
+                                 const Transform &render_from_object) const;
+
     void parse_texture(const std::vector<Token> &tokens);
 
     void parse_transform(const std::vector<Token> &tokens);
@@ -179,18 +230,40 @@ class SceneBuilder {
             exit(1);
         }
 
-        auto builder = SceneBuilder(command_line_option);
+        const auto input_file = command_line_option.input_file;
+        const auto extension = std::filesystem::path(input_file).extension();
 
-        auto input_file = command_line_option.input_file;
+        if (command_line_option.compile_scene_file.has_value()) {
+            if (extension != ".pbrt") {
+                printf("ERROR: input file `%s` not ended with `.pbrt`\n", input_file.c_str());
+                REPORT_FATAL_ERROR();
+            }
 
-        if (std::filesystem::path p(input_file); p.extension() != ".pbrt") {
-            printf("ERROR: input file `%s` not ended with `.pbrt`\n", input_file.c_str());
-            REPORT_FATAL_ERROR();
+            const auto compiled_scene_file = command_line_option.compile_scene_file.value();
+            CompiledScene::compile(input_file).write(compiled_scene_file);
+
+            std::cout << "compiled scene saved to `" << compiled_scene_file << "`\n";
+            return;
         }
 
-        builder.root = get_dirname(input_file);
+        auto builder = SceneBuilder(command_line_option);
 
-        builder.parse_file(input_file);
+        if (extension == ".pbsc") {
+            auto compiled_scene = CompiledScene::read(input_file);
+
+            builder.root = compiled_scene.root;
+            builder.ply_meshes = std::move(compiled_scene.ply_meshes);
+            builder.parse_tokens(compiled_scene.tokens);
+
+        } else if (extension == ".pbrt") {
+            builder.root = get_dirname(input_file);
+            builder.parse_file(input_file);
+
+        } else {
+            printf("ERROR: input file `%s` not ended with `.pbrt` or `.pbsc`\n",
+                   input_file.c_str());
+            REPORT_FATAL_ERROR();
+        }
 
         builder.preprocess();
 
@@ -1,122 +1,143 @@
 #include <pbrt/euclidean_space/normal3f.h>
 #include <pbrt/shapes/loop_subdivide.h>
-#include <map>
-#include <memory>
-#include <set>
+#include <pbrt/util/math.h>
+#include <pbrt/util/thread_pool.h>
+#include <unordered_map>
 
 namespace {
-struct SDFace;
-struct SDVertex;
-
 // LoopSubdiv Macros
 #define NEXT(i) (((i) + 1) % 3)
 #define PREV(i) (((i) + 2) % 3)
 
-// LoopSubdiv Local Structures
-struct SDVertex {
-    // SDVertex Constructor
-    SDVertex(const Point3f &p = Point3f(0, 0, 0)) : p(p) {}
-
-    // SDVertex Methods
-    int valence();
-    void oneRing(Point3f *p);
-    Point3f p;
-    SDFace *startFace = nullptr;
-    SDVertex *child = nullptr;
-    bool regular = false, boundary = false;
-};
+constexpr int NO_FACE = -1;
 
-struct SDFace {
-    // SDFace Constructor
-    SDFace() {
-        for (int i = 0; i < 3; ++i) {
-            v[i] = nullptr;
-            f[i] = nullptr;
-        }
-        for (int i = 0; i < 4; ++i) {
-            children[i] = nullptr;
-        }
+// one subdivision level as flat arrays: face f owns corners [3f, 3f + 3) of `vertices` and
+// `neighbors`, where neighbors[3f + k] is the face across edge (vertices[3f + k], vertices[3f +
+// NEXT(k)])
+struct SDMesh {
+    std::vector<Point3f> p;
+    std::vector<int> start_face;
+    std::vector<uint8_t> boundary;
+
+    std::vector<int> vertices;
+    std::vector<int> neighbors;
+
+    [[nodiscard]] int num_faces() const {
+        return vertices.size() / 3;
     }
 
-    // SDFace Methods
-    int vnum(SDVertex *vert) const {
+    [[nodiscard]] int vnum(const int face, const int vert) const {
         for (int i = 0; i < 3; ++i) {
-            if (v[i] == vert) {
+            if (vertices[3 * face + i] == vert) {
                 return i;
             }
         }
 
         return -1;
     }
-    SDFace *nextFace(SDVertex *vert) {
-        return f[vnum(vert)];
+
+    [[nodiscard]] int next_face(const int face, const int vert) const {
+        return neighbors[3 * face + vnum(face, vert)];
     }
-    SDFace *prevFace(SDVertex *vert) {
-        return f[PREV(vnum(vert))];
+
+    [[nodiscard]] int prev_face(const int face, const int vert) const {
+        return neighbors[3 * face + PREV(vnum(face, vert))];
     }
-    SDVertex *nextVert(SDVertex *vert) {
-        return v[NEXT(vnum(vert))];
+
+    [[nodiscard]] int next_vert(const int face, const int vert) const {
+        return vertices[3 * face + NEXT(vnum(face, vert))];
     }
-    SDVertex *prevVert(SDVertex *vert) {
-        return v[PREV(vnum(vert))];
+
+    [[nodiscard]] int prev_vert(const int face, const int vert) const {
+        return vertices[3 * face + PREV(vnum(face, vert))];
     }
-    SDVertex *otherVert(SDVertex *v0, SDVertex *v1) {
+
+    [[nodiscard]] int other_vert(const int face, const int v0, const int v1) const {
         for (int i = 0; i < 3; ++i) {
-            if (v[i] != v0 && v[i] != v1) {
-                return v[i];
+            const auto vert = vertices[3 * face + i];
+            if (vert != v0 && vert != v1) {
+                return vert;
             }
         }
 
-        return nullptr;
-    }
-    SDVertex *v[3];
-    SDFace *f[3];
-    SDFace *children[4];
-};
-
-struct SDEdge {
-    // SDEdge Constructor
-    SDEdge(SDVertex *v0 = nullptr, SDVertex *v1 = nullptr) {
-        v[0] = std::min(v0, v1);
-        v[1] = std::max(v0, v1);
-        f[0] = f[1] = nullptr;
-        f0edgeNum = -1;
-    }
-
-    // SDEdge Comparison Function
-    bool operator<(const SDEdge &e2) const {
-        if (v[0] == e2.v[0])
-            return v[1] < e2.v[1];
-        return v[0] < e2.v[0];
+        return -1;
     }
-    SDVertex *v[2];
-    SDFace *f[2];
-    int f0edgeNum;
-};
 
-// LoopSubdiv Inline Functions
-inline int SDVertex::valence() {
-    SDFace *f = startFace;
-    if (!boundary) {
-        // Compute valence of interior vertex
-        int nf = 1;
-        while ((f = f->nextFace(this)) != startFace) {
-            ++nf;
+    [[nodiscard]] int valence(const int vert) const {
+        int face = start_face[vert];
+        if (!boundary[vert]) {
+            // Compute valence of interior vertex
+            int nf = 1;
+            while ((face = next_face(face, vert)) != start_face[vert]) {
+                ++nf;
+            }
+            return nf;
         }
-        return nf;
-    } else {
+
         // Compute valence of boundary vertex
         int nf = 1;
-        while ((f = f->nextFace(this)) != nullptr) {
+        while ((face = next_face(face, vert)) != NO_FACE) {
             ++nf;
         }
-        f = startFace;
-        while ((f = f->prevFace(this)) != nullptr) {
+        face = start_face[vert];
+        while ((face = prev_face(face, vert)) != NO_FACE) {
             ++nf;
         }
         return nf + 1;
     }
-}
+
+    // visits the one-ring of `vert` in the same order as pbrt's SDVertex::oneRing()
+    template <typename Function>
+    void one_ring(const int vert, Function &&function) const {
+        int face = start_face[vert];
+
+        if (!boundary[vert]) {
+            // Get one-ring vertices for interior vertex
+            do {
+                function(p[next_vert(face, vert)]);
+                face = next_face(face, vert);
+            } while (face != start_face[vert]);
+
+            return;
+        }
+
+        // Get one-ring vertices for boundary vertex
+        for (int next = next_face(face, vert); next != NO_FACE; next = next_face(face, vert)) {
+            face = next;
+        }
+
+        function(p[next_vert(face, vert)]);
+        do {
+            function(p[prev_vert(face, vert)]);
+            face = prev_face(face, vert);
+        } while (face != NO_FACE);
+    }
+
+    [[nodiscard]] Point3f weight_one_ring(const int vert, const FloatType beta) const {
+        Point3f result = (1 - valence(vert) * beta) * p[vert];
+        one_ring(vert, [&](const Point3f &ring_p) { result += beta * ring_p; });
+
+        return result;
+    }
+
+    [[nodiscard]] Point3f weight_boundary(const int vert, const FloatType beta) const {
+        bool first_visited = false;
+        Point3f first(0, 0, 0);
+        Point3f last(0, 0, 0);
+        one_ring(vert, [&](const Point3f &ring_p) {
+            if (!first_visited) {
+                first = ring_p;
+                first_visited = true;
+            }
+            last = ring_p;
+        });
+
+        Point3f result = (1 - 2 * beta) * p[vert];
+        result += beta * first;
+        result += beta * last;
+        return result;
+    }
+};
 
 inline FloatType beta(int valence) {
     if (valence == 3) {
@@ -130,261 +151,251 @@ inline FloatType loopGamma(int valence) {
     return 1.f / (valence + 3.f / (8.f * beta(valence)));
 }
 
-static Point3f weightOneRing(SDVertex *vert, FloatType beta) {
-    // Put _vert_ one-ring in _pRing_
-    int valence = vert->valence();
-    auto pRing = std::vector<Point3f>(valence);
+uint64_t edge_key(const int v0, const int v1) {
+    return (uint64_t(std::min(v0, v1)) << 32) | uint64_t(std::max(v0, v1));
+}
 
-    vert->oneRing(pRing.data());
-    Point3f p = (1 - valence * beta) * vert->p;
-    for (int i = 0; i < valence; ++i) {
-        p += beta * pRing[i];
-    }
+template <typename Function>
+void parallel_for(ThreadPool &thread_pool, const int num, Function &&function) {
+    constexpr int chunk_size = 4096;
 
-    return p;
+    thread_pool.parallel_execute(0, divide_and_ceil(num, chunk_size), [&](const int chunk) {
+        const int end = std::min(num, (chunk + 1) * chunk_size);
+        for (int idx = chunk * chunk_size; idx < end; ++idx) {
+            function(idx);
+        }
+    });
 }
 
-void SDVertex::oneRing(Point3f *p) {
-    if (!boundary) {
-        // Get one-ring vertices for interior vertex
-        SDFace *face = startFace;
-        do {
-            *p++ = face->nextVert(this)->p;
-            face = face->nextFace(this);
-        } while (face != startFace);
-    } else {
-        // Get one-ring vertices for boundary vertex
-        SDFace *face = startFace, *f2;
-        while ((f2 = face->nextFace(this)) != nullptr)
-            face = f2;
-        *p++ = face->nextVert(this)->p;
-        do {
-            *p++ = face->prevVert(this)->p;
-            face = face->prevFace(this);
-        } while (face != nullptr);
+SDMesh subdivide(const SDMesh &mesh, ThreadPool &thread_pool) {
+    const int num_vertices = mesh.p.size();
+    const int num_faces = mesh.num_faces();
+
+    // an edge's odd vertex is created by the first face (in face order) visiting it
+    auto is_edge_owner = [&mesh](const int face, const int k) {
+        const auto neighbor = mesh.neighbors[3 * face + k];
+        return neighbor == NO_FACE || face <= neighbor;
+    };
+
+    std::vector<int> odd_offsets(num_faces + 1, 0);
+    parallel_for(thread_pool, num_faces, [&](const int face) {
+        int num_owned = 0;
+        for (int k = 0; k < 3; ++k) {
+            num_owned += is_edge_owner(face, k);
+        }
+        odd_offsets[face + 1] = num_owned;
+    });
+
+    for (int face = 0; face < num_faces; ++face) {
+        odd_offsets[face + 1] += odd_offsets[face];
     }
-}
 
-static Point3f weightBoundary(SDVertex *vert, FloatType beta) {
-    // Put _vert_ one-ring in _pRing_
-    int valence = vert->valence();
-    auto pRing = std::vector<Point3f>(valence);
+    const int num_child_vertices = num_vertices + odd_offsets[num_faces];
+
+    SDMesh child;
+    child.p.resize(num_child_vertices);
+    child.start_face.resize(num_child_vertices);
+    child.boundary.resize(num_child_vertices);
+    child.vertices.resize(4 * mesh.vertices.size());
+    child.neighbors.resize(4 * mesh.vertices.size());
+
+    // Update vertex positions for even vertices
+    parallel_for(thread_pool, num_vertices, [&](const int vert) {
+        child.boundary[vert] = mesh.boundary[vert];
+
+        const auto start_face = mesh.start_face[vert];
+        if (start_face == NO_FACE) {
+            // not referenced by any face
+            child.p[vert] = mesh.p[vert];
+            child.start_face[vert] = NO_FACE;
+            return;
+        }
 
-    vert->oneRing(pRing.data());
-    Point3f p = (1 - 2 * beta) * vert->p;
-    p += beta * pRing[0];
-    p += beta * pRing[valence - 1];
-    return p;
-}
+        child.p[vert] = mesh.boundary[vert] ? mesh.weight_boundary(vert, 1.f / 8.f)
+                                            : mesh.weight_one_ring(vert, beta(mesh.valence(vert)));
+        child.start_face[vert] = 4 * start_face + mesh.vnum(start_face, vert);
+    });
 
-} // namespace
+    // Compute new odd edge vertices
+    std::vector<int> edge_vertices(mesh.vertices.size());
+    parallel_for(thread_pool, num_faces, [&](const int face) {
+        int odd_vert = num_vertices + odd_offsets[face];
 
-LoopSubdivide::LoopSubdivide(int nLevels, const std::vector<int> &vertexIndices,
-                             const std::vector<Point3f> &p) {
-    std::vector<SDVertex *> vertices;
-    std::vector<SDFace *> faces;
-    // Allocate _LoopSubdiv_ vertices and faces
-    std::unique_ptr<SDVertex[]> verts = std::make_unique<SDVertex[]>(p.size());
-    for (int i = 0; i < p.size(); ++i) {
-        verts[i] = SDVertex(p[i]);
-        vertices.push_back(&verts[i]);
-    }
+        for (int k = 0; k < 3; ++k) {
+            if (!is_edge_owner(face, k)) {
+                continue;
+            }
 
-    size_t nFaces = vertexIndices.size() / 3;
-    std::unique_ptr<SDFace[]> fs = std::make_unique<SDFace[]>(nFaces);
-    for (int i = 0; i < nFaces; ++i) {
-        faces.push_back(&fs[i]);
-    }
+            const auto v0 = mesh.vertices[3 * face + k];
+            const auto v1 = mesh.vertices[3 * face + NEXT(k)];
+            const auto neighbor = mesh.neighbors[3 * face + k];
 
-    // Set face to vertex pointers
-    const int *vp = vertexIndices.data();
-    for (size_t i = 0; i < nFaces; ++i, vp += 3) {
-        SDFace *f = faces[i];
-        for (int j = 0; j < 3; ++j) {
-            SDVertex *v = vertices[vp[j]];
-            f->v[j] = v;
-            v->startFace = f;
-        }
-    }
+            child.boundary[odd_vert] = neighbor == NO_FACE;
+            child.start_face[odd_vert] = 4 * face + 3;
 
-    // Set neighbor pointers in _faces_
-    std::set<SDEdge> edges;
-    for (int i = 0; i < nFaces; ++i) {
-        SDFace *f = faces[i];
-        for (int edgeNum = 0; edgeNum < 3; ++edgeNum) {
-            // Update neighbor pointer for _edgeNum_
-            int v0 = edgeNum, v1 = NEXT(edgeNum);
-            SDEdge e(f->v[v0], f->v[v1]);
-            if (edges.find(e) == edges.end()) {
-                // Handle new edge
-                e.f[0] = f;
-                e.f0edgeNum = edgeNum;
-                edges.insert(e);
+            // Apply edge rules to compute new vertex position
+            Point3f p;
+            if (neighbor == NO_FACE) {
+                p = 0.5f * mesh.p[v0];
+                p += 0.5f * mesh.p[v1];
             } else {
-                // Handle previously seen edge
-                e = *edges.find(e);
-                e.f[0]->f[e.f0edgeNum] = f;
-                f->f[edgeNum] = e.f[0];
-                edges.erase(e);
+                p = 3.f / 8.f * mesh.p[v0];
+                p += 3.f / 8.f * mesh.p[v1];
+                p += 1.f / 8.f * mesh.p[mesh.other_vert(face, v0, v1)];
+                p += 1.f / 8.f * mesh.p[mesh.other_vert(neighbor, v0, v1)];
             }
-        }
-    }
+            child.p[odd_vert] = p;
 
-    // Finish vertex initialization
-    for (size_t i = 0; i < p.size(); ++i) {
-        SDVertex *v = vertices[i];
-        SDFace *f = v->startFace;
-        do {
-            f = f->nextFace(v);
-        } while ((f != nullptr) && f != v->startFace);
-        v->boundary = (f == nullptr);
-
-        if (!v->boundary && v->valence() == 6) {
-            v->regular = true;
-        } else if (v->boundary && v->valence() == 4) {
-            v->regular = true;
-        } else {
-            v->regular = false;
+            edge_vertices[3 * face + k] = odd_vert;
+            odd_vert += 1;
         }
-    }
+    });
 
-    // Refine _LoopSubdiv_ into triangles
-    std::vector<SDFace *> f = faces;
-    std::vector<SDVertex *> v = vertices;
-
-    for (int i = 0; i < nLevels; ++i) {
-        // Update _f_ and _v_ for next level of subdivision
-        std::vector<SDFace *> newFaces;
-        std::vector<SDVertex *> newVertices;
-
-        // Allocate next level of children in mesh tree
-        for (SDVertex *vertex : v) {
-            vertex->child = new SDVertex();
-            vertex->child->regular = vertex->regular;
-            vertex->child->boundary = vertex->boundary;
-            newVertices.push_back(vertex->child);
-        }
-        for (SDFace *face : f) {
-            for (int k = 0; k < 4; ++k) {
-                face->children[k] = new SDFace();
-                newFaces.push_back(face->children[k]);
+    // edges not owned by a face reuse the odd vertex of the matching edge in its neighbor
+    parallel_for(thread_pool, num_faces, [&](const int face) {
+        for (int k = 0; k < 3; ++k) {
+            if (is_edge_owner(face, k)) {
+                continue;
             }
-        }
-
-        // Update vertex positions and create new edge vertices
 
-        // Update vertex positions for even vertices
-        for (SDVertex *vertex : v) {
-            if (!vertex->boundary) {
-                // Apply one-ring rule for even vertex
-                if (vertex->regular)
-                    vertex->child->p = weightOneRing(vertex, 1.f / 16.f);
-                else
-                    vertex->child->p = weightOneRing(vertex, beta(vertex->valence()));
-            } else {
-                // Apply boundary rule for even vertex
-                vertex->child->p = weightBoundary(vertex, 1.f / 8.f);
+            const auto key =
+                edge_key(mesh.vertices[3 * face + k], mesh.vertices[3 * face + NEXT(k)]);
+            const auto neighbor = mesh.neighbors[3 * face + k];
+            for (int m = 0; m < 3; ++m) {
+                if (edge_key(mesh.vertices[3 * neighbor + m],
+                             mesh.vertices[3 * neighbor + NEXT(m)]) == key) {
+                    edge_vertices[3 * face + k] = edge_vertices[3 * neighbor + m];
+                    break;
+                }
             }
         }
+    });
 
-        // Compute new odd edge vertices
-        std::map<SDEdge, SDVertex *> edgeVerts;
-        for (SDFace *face : f) {
-            for (int k = 0; k < 3; ++k) {
-                // Compute odd vertex on _k_th edge
-                SDEdge edge(face->v[k], face->v[NEXT(k)]);
-                SDVertex *vert = edgeVerts[edge];
-                if (vert == nullptr) {
-                    // Create and initialize new odd vertex
-                    vert = new SDVertex();
-                    newVertices.push_back(vert);
-                    vert->regular = true;
-                    vert->boundary = (face->f[k] == nullptr);
-                    vert->startFace = face->children[3];
-
-                    // Apply edge rules to compute new vertex position
-                    if (vert->boundary) {
-                        vert->p = 0.5f * edge.v[0]->p;
-                        vert->p += 0.5f * edge.v[1]->p;
-                    } else {
-                        vert->p = 3.f / 8.f * edge.v[0]->p;
-                        vert->p += 3.f / 8.f * edge.v[1]->p;
-                        vert->p += 1.f / 8.f * face->otherVert(edge.v[0], edge.v[1])->p;
-                        vert->p += 1.f / 8.f * face->f[k]->otherVert(edge.v[0], edge.v[1])->p;
-                    }
-                    edgeVerts[edge] = vert;
-                }
-            }
+    // Update new mesh topology: face f splits into children [4f, 4f + 4)
+    parallel_for(thread_pool, num_faces, [&](const int face) {
+        const int center = 4 * face + 3;
+
+        for (int j = 0; j < 3; ++j) {
+            const int corner = 4 * face + j;
+            const auto vert = mesh.vertices[3 * face + j];
+
+            // Update child vertex pointers to new even and odd vertices
+            child.vertices[3 * corner + j] = vert;
+            child.vertices[3 * corner + NEXT(j)] = edge_vertices[3 * face + j];
+            child.vertices[3 * corner + PREV(j)] = edge_vertices[3 * face + PREV(j)];
+            child.vertices[3 * center + j] = edge_vertices[3 * face + j];
+
+            // Update children neighbor pointers for siblings
+            child.neighbors[3 * center + j] = 4 * face + NEXT(j);
+            child.neighbors[3 * corner + NEXT(j)] = center;
+
+            // Update children neighbor pointers for neighbor children
+            auto f2 = mesh.neighbors[3 * face + j];
+            child.neighbors[3 * corner + j] =
+                f2 != NO_FACE ? 4 * f2 + mesh.vnum(f2, vert) : NO_FACE;
+            f2 = mesh.neighbors[3 * face + PREV(j)];
+            child.neighbors[3 * corner + PREV(j)] =
+                f2 != NO_FACE ? 4 * f2 + mesh.vnum(f2, vert) : NO_FACE;
         }
+    });
+
+    return child;
+}
+} // namespace
+
+LoopSubdivide::LoopSubdivide(int nLevels, const std::vector<int> &vertexIndices,
+                             const std::vector<Point3f> &p) {
+    ThreadPool thread_pool;
 
-        // Update new mesh topology
+    SDMesh mesh;
+    mesh.p = p;
+    mesh.vertices = vertexIndices;
+    mesh.start_face.assign(p.size(), NO_FACE);
+    mesh.boundary.assign(p.size(), false);
+    mesh.neighbors.assign(vertexIndices.size(), NO_FACE);
 
-        // Update even vertex face pointers
-        for (SDVertex *vertex : v) {
-            int vertNum = vertex->startFace->vnum(vertex);
-            vertex->child->startFace = vertex->startFace->children[vertNum];
+    const int nFaces = mesh.num_faces();
+
+    // Set face to vertex pointers
+    for (int face = 0; face < nFaces; ++face) {
+        for (int j = 0; j < 3; ++j) {
+            mesh.start_face[mesh.vertices[3 * face + j]] = face;
         }
+    }
+
+    // Set neighbor pointers in faces: map an unmatched edge to its first corner
+    std::unordered_map<uint64_t, int> edges;
+    edges.reserve(vertexIndices.size());
+    for (int face = 0; face < nFaces; ++face) {
+        for (int edgeNum = 0; edgeNum < 3; ++edgeNum) {
+            const auto key = edge_key(mesh.vertices[3 * face + edgeNum],
+                                      mesh.vertices[3 * face + NEXT(edgeNum)]);
 
-        // Update face neighbor pointers
-        for (SDFace *face : f) {
-            for (int j = 0; j < 3; ++j) {
-                // Update children _f_ pointers for siblings
-                face->children[3]->f[j] = face->children[NEXT(j)];
-                face->children[j]->f[NEXT(j)] = face->children[3];
-
-                // Update children _f_ pointers for neighbor children
-                SDFace *f2 = face->f[j];
-                face->children[j]->f[j] =
-                    f2 != nullptr ? f2->children[f2->vnum(face->v[j])] : nullptr;
-                f2 = face->f[PREV(j)];
-                face->children[j]->f[PREV(j)] =
-                    f2 != nullptr ? f2->children[f2->vnum(face->v[j])] : nullptr;
+            const auto matched_edge = edges.find(key);
+            if (matched_edge == edges.end()) {
+                // Handle new edge
+                edges[key] = 3 * face + edgeNum;
+                continue;
             }
+
+            // Handle previously seen edge
+            const int corner = matched_edge->second;
+            mesh.neighbors[corner] = face;
+            mesh.neighbors[3 * face + edgeNum] = corner / 3;
+            edges.erase(matched_edge);
         }
+    }
 
-        // Update face vertex pointers
-        for (SDFace *face : f) {
-            for (int j = 0; j < 3; ++j) {
-                // Update child vertex pointer to new even vertex
-                face->children[j]->v[j] = face->v[j]->child;
-
-                // Update child vertex pointer to new odd vertex
-                SDVertex *vert = edgeVerts[SDEdge(face->v[j], face->v[NEXT(j)])];
-                face->children[j]->v[NEXT(j)] = vert;
-                face->children[NEXT(j)]->v[j] = vert;
-                face->children[3]->v[j] = vert;
-            }
+    // Finish vertex initialization
+    parallel_for(thread_pool, p.size(), [&](const int vert) {
+        int face = mesh.start_face[vert];
+        if (face == NO_FACE) {
+            return;
         }
 
-        // Prepare for next level of subdivision
-        f = newFaces;
-        v = newVertices;
+        do {
+            face = mesh.next_face(face, vert);
+        } while (face != NO_FACE && face != mesh.start_face[vert]);
+        mesh.boundary[vert] = face == NO_FACE;
+    });
+
+    // Refine _LoopSubdiv_ into triangles
+    for (int level = 0; level < nLevels; ++level) {
+        mesh = subdivide(mesh, thread_pool);
     }
 
     // Push vertices to limit surface
-    std::vector<Point3f> _p_limit(v.size());
-    for (size_t i = 0; i < v.size(); ++i) {
-        _p_limit[i] = v[i]->boundary ? weightBoundary(v[i], 1.f / 5.f)
-                                     : weightOneRing(v[i], loopGamma(v[i]->valence()));
-    }
+    const int num_vertices = mesh.p.size();
+    std::vector<Point3f> _p_limit(num_vertices);
+    parallel_for(thread_pool, num_vertices, [&](const int vert) {
+        if (mesh.start_face[vert] == NO_FACE) {
+            _p_limit[vert] = mesh.p[vert];
+            return;
+        }
 
-    for (size_t i = 0; i < v.size(); ++i) {
-        v[i]->p = _p_limit[i];
-    }
+        _p_limit[vert] = mesh.boundary[vert]
+                             ? mesh.weight_boundary(vert, 1.f / 5.f)
+                             : mesh.weight_one_ring(vert, loopGamma(mesh.valence(vert)));
+    });
+    mesh.p = _p_limit;
 
     // Compute vertex tangents on limit surface
-
-    normals.reserve(v.size());
-    std::vector<Point3f> pRing(16, Point3f());
-    for (SDVertex *vertex : v) {
-        Vector3f S(0, 0, 0), T(0, 0, 0);
-        int valence = vertex->valence();
-        if (valence > (int)pRing.size()) {
-            pRing.resize(valence);
+    normals.resize(num_vertices);
+    parallel_for(thread_pool, num_vertices, [&](const int vert) {
+        if (mesh.start_face[vert] == NO_FACE) {
+            normals[vert] = Normal3f(0, 0, 0);
+            return;
         }
 
-        vertex->oneRing(&pRing[0]);
-        if (!vertex->boundary) {
+        thread_local std::vector<Point3f> pRing;
+        pRing.clear();
+        mesh.one_ring(vert, [](const Point3f &ring_p) { pRing.push_back(ring_p); });
+
+        const int valence = pRing.size();
+        const auto vertex_p = mesh.p[vert];
+
+        Vector3f S(0, 0, 0), T(0, 0, 0);
+        if (!mesh.boundary[vert]) {
             // Compute tangents of interior face
             for (int j = 0; j < valence; ++j) {
                 S += std::cos(2 * compute_pi() * j / valence) * pRing[j].to_vector3();
@@ -394,11 +405,11 @@ LoopSubdivide::LoopSubdivide(int nLevels, const std::vector<int> &vertexIndices,
             // Compute tangents of boundary face
             S = pRing[valence - 1] - pRing[0];
             if (valence == 2)
-                T = Vector3f(pRing[0] + pRing[1] - 2 * vertex->p);
+                T = Vector3f(pRing[0] + pRing[1] - 2 * vertex_p);
             else if (valence == 3)
-                T = pRing[1] - vertex->p;
+                T = pRing[1] - vertex_p;
             else if (valence == 4) // regular
-                T = (-1 * pRing[0] + 2 * pRing[1] + 2 * pRing[2] + -1 * pRing[3] + -2 * vertex->p)
+                T = (-1 * pRing[0] + 2 * pRing[1] + 2 * pRing[2] + -1 * pRing[3] + -2 * vertex_p)
                         .to_vector3();
             else {
                 FloatType theta = compute_pi() / FloatType(valence - 1);
@@ -410,25 +421,9 @@ LoopSubdivide::LoopSubdivide(int nLevels, const std::vector<int> &vertexIndices,
                 T = -T;
             }
         }
-        normals.push_back(Normal3f(S.cross(T)));
-    }
+        normals[vert] = Normal3f(S.cross(T));
+    });
 
-    {
-        size_t n_triangles = f.size();
-        std::vector<int> _vertex_indices(3 * n_triangles);
-        int *ptr_vertex_indices = _vertex_indices.data();
-        size_t totVerts = v.size();
-        std::map<SDVertex *, int> usedVerts;
-        for (size_t i = 0; i < totVerts; ++i)
-            usedVerts[v[i]] = i;
-        for (size_t i = 0; i < n_triangles; ++i) {
-            for (int j = 0; j < 3; ++j) {
-                *ptr_vertex_indices = usedVerts[f[i]->v[j]];
-                ++ptr_vertex_indices;
-            }
-        }
-
-        vertex_indices = _vertex_indices;
-        p_limit = _p_limit;
-    }
+    vertex_indices = std::move(mesh.vertices);
+    p_limit = std::move(_p_limit);
 }
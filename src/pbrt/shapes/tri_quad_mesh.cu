@@ -2,7 +2,11 @@
 
 struct FaceCallbackContext {
     int face[4];
-    std::vector<int> triIndices, quadIndices;
+    std::vector<int> *triIndices = nullptr;
+
+    // only recorded when the file carries face_indices (1 for a triangle, 2 for a quad)
+    bool record_triangles_per_face = false;
+    std::vector<uint8_t> triangles_per_face;
 };
 
 void rply_message_callback(p_ply ply, const char *message) {
@@ -38,6 +42,11 @@ int rply_face_callback(p_ply_argument argument) {
         printf("plymesh: Ignoring face with %d vertices (only triangles and quads "
                "are supported!)",
                (int)length);
+
+        // its face index is still read: it maps to no triangle
+        if (value_index < 0 && context->record_triangles_per_face) {
+            context->triangles_per_face.push_back(0);
+        }
         return 1;
     } else if (value_index < 0) {
         return 1;
@@ -48,15 +57,23 @@ int rply_face_callback(p_ply_argument argument) {
     }
 
     if (value_index == length - 1) {
+        auto &triIndices = *context->triIndices;
         if (length == 3)
             for (int i = 0; i < 3; ++i)
-                context->triIndices.push_back(context->face[i]);
+                triIndices.push_back(context->face[i]);
         else {
-            // Note: modify order since we're specifying it as a blp...
-            context->quadIndices.push_back(context->face[0]);
-            context->quadIndices.push_back(context->face[1]);
-            context->quadIndices.push_back(context->face[3]);
-            context->quadIndices.push_back(context->face[2]);
+            // split the quad along its 0-2 diagonal
+            triIndices.push_back(context->face[0]);
+            triIndices.push_back(context->face[1]);
+            triIndices.push_back(context->face[2]);
+
+            triIndices.push_back(context->face[0]);
+            triIndices.push_back(context->face[2]);
+            triIndices.push_back(context->face[3]);
+        }
+
+        if (context->record_triangles_per_face) {
+            context->triangles_per_face.push_back(length - 2);
         }
     }
 
@@ -145,8 +162,8 @@ TriQuadMesh TriQuadMesh::read_ply(const std::string &filename) {
     }
 
     FaceCallbackContext context;
-    context.triIndices.reserve(faceCount * 3);
-    context.quadIndices.reserve(faceCount * 4);
+    context.triIndices = &mesh.triIndices;
+    mesh.triIndices.reserve(faceCount * 3);
     if (ply_set_read_cb(ply, "face", "vertex_indices", rply_face_callback, &context, 0) == 0) {
         printf("%s: vertex indices not found in PLY file", filename.c_str());
         exit(1);
@@ -155,6 +172,8 @@ TriQuadMesh TriQuadMesh::read_ply(const std::string &filename) {
     if (ply_set_read_cb(ply, "face", "face_indices", rply_faceindex_callback, &mesh.faceIndices,
                         0) != 0) {
         mesh.faceIndices.reserve(faceCount);
+        context.record_triangles_per_face = true;
+        context.triangles_per_face.reserve(faceCount);
     }
 
     if (ply_read(ply) == 0) {
@@ -162,21 +181,24 @@ TriQuadMesh TriQuadMesh::read_ply(const std::string &filename) {
         exit(1);
     }
 
-    mesh.triIndices = std::move(context.triIndices);
-    mesh.quadIndices = std::move(context.quadIndices);
-
     ply_close(ply);
 
-    for (int idx : mesh.triIndices) {
-        if (idx < 0 || idx >= mesh.p.size()) {
-            printf("plymesh: Vertex index %d is out of bounds! "
-                   "Valid range is [0..%d)",
-                   idx, int(mesh.p.size()));
-            exit(1);
+    if (mesh.faceIndices.size() == context.triangles_per_face.size() &&
+        mesh.faceIndices.size() * 3 != mesh.triIndices.size()) {
+        // quads were split or faces skipped: repeat each face index once per triangle of its face
+        std::vector<int> triangle_face_indices;
+        triangle_face_indices.reserve(mesh.triIndices.size() / 3);
+
+        for (size_t face = 0; face < mesh.faceIndices.size(); ++face) {
+            for (uint idx = 0; idx < context.triangles_per_face[face]; ++idx) {
+                triangle_face_indices.push_back(mesh.faceIndices[face]);
+            }
         }
+
+        mesh.faceIndices = std::move(triangle_face_indices);
     }
 
-    for (int idx : mesh.quadIndices) {
+    for (int idx : mesh.triIndices) {
         if (idx < 0 || idx >= mesh.p.size()) {
             printf("plymesh: Vertex index %d is out of bounds! "
                    "Valid range is [0..%d)",
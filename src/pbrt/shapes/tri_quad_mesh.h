@@ -12,8 +12,8 @@ struct TriQuadMesh {
     std::vector<Normal3f> n;
     std::vector<Point2f> uv;
     std::vector<int> faceIndices;
+    // quads are split into triangles while reading
     std::vector<int> triIndices;
-    std::vector<int> quadIndices;
 
     static TriQuadMesh read_ply(const std::string &filename);
 };
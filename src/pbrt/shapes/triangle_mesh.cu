@@ -36,11 +36,41 @@ static __global__ void init_shapes(Shape *shapes, const TypeOfShape *concrete_sh
     shapes[worker_idx].init(&concrete_shapes[worker_idx]);
 }
 
+TriangleMesh::SharedBuffers TriangleMesh::upload_shared_buffers(const std::vector<int> &indices,
+                                                               const std::vector<Point2f> &uv,
+                                                               GPUMemoryAllocator &allocator) {
+    auto gpu_indices = allocator.allocate<int>(indices.size());
+    CHECK_CUDA_ERROR(cudaMemcpy(gpu_indices, indices.data(), sizeof(int) * indices.size(),
+                                cudaMemcpyHostToDevice));
+
+    Point2f *gpu_uv = nullptr;
+    if (!uv.empty()) {
+        gpu_uv = allocator.allocate<Point2f>(uv.size());
+        CHECK_CUDA_ERROR(
+            cudaMemcpy(gpu_uv, uv.data(), sizeof(Point2f) * uv.size(), cudaMemcpyHostToDevice));
+    }
+
+    return {
+        .indices = gpu_indices,
+        .num_indices = static_cast<uint>(indices.size()),
+        .uv = gpu_uv,
+    };
+}
+
 std::pair<const Shape *, uint>
 TriangleMesh::build_triangles(const Transform &render_from_object, bool reverse_orientation,
                               const std::vector<Point3f> &points, const std::vector<int> &indices,
                               const std::vector<Normal3f> &normals, const std::vector<Point2f> &uv,
                               GPUMemoryAllocator &allocator) {
+    return build_triangles(render_from_object, reverse_orientation, points, normals,
+                           upload_shared_buffers(indices, uv, allocator), allocator);
+}
+
+std::pair<const Shape *, uint>
+TriangleMesh::build_triangles(const Transform &render_from_object, bool reverse_orientation,
+                              const std::vector<Point3f> &points,
+                              const std::vector<Normal3f> &normals,
+                              const SharedBuffers &shared_buffers, GPUMemoryAllocator &allocator) {
     auto gpu_points = allocator.allocate<Point3f>(points.size());
     CHECK_CUDA_ERROR(cudaMemcpy(gpu_points, points.data(), sizeof(Point3f) * points.size(),
                                 cudaMemcpyHostToDevice));
@@ -56,10 +86,6 @@ TriangleMesh::build_triangles(const Transform &render_from_object, bool reverse_
         CHECK_CUDA_ERROR(cudaDeviceSynchronize());
     }
 
-    auto gpu_indices = allocator.allocate<int>(indices.size());
-    CHECK_CUDA_ERROR(cudaMemcpy(gpu_indices, indices.data(), sizeof(int) * indices.size(),
-                                cudaMemcpyHostToDevice));
-
     Normal3f *gpu_normals = nullptr;
     if (!normals.empty()) {
         gpu_normals = allocator.allocate<Normal3f>(normals.size());
@@ -75,15 +101,9 @@ TriangleMesh::build_triangles(const Transform &render_from_object, bool reverse_
         }
     }
 
-    Point2f *gpu_uv = nullptr;
-    if (!uv.empty()) {
-        gpu_uv = allocator.allocate<Point2f>(uv.size());
-        CHECK_CUDA_ERROR(
-            cudaMemcpy(gpu_uv, uv.data(), sizeof(Point2f) * uv.size(), cudaMemcpyHostToDevice));
-    }
-
     auto mesh = allocator.allocate<TriangleMesh>();
-    mesh->init(reverse_orientation, gpu_indices, indices.size(), gpu_points, gpu_normals, gpu_uv);
+    mesh->init(reverse_orientation, shared_buffers.indices, shared_buffers.num_indices, gpu_points,
+               gpu_normals, shared_buffers.uv);
 
     uint num_triangles = mesh->triangles_num;
 
@@ -20,12 +20,28 @@ class TriangleMesh {
     bool reverse_orientation;
     bool transformSwapsHandedness;
 
+    // indices and uv don't depend on the transform: one upload backs every mesh built upon it
+    struct SharedBuffers {
+        const int *indices = nullptr;
+        uint num_indices = 0;
+        const Point2f *uv = nullptr;
+    };
+
+    static SharedBuffers upload_shared_buffers(const std::vector<int> &indices,
+                                               const std::vector<Point2f> &uv,
+                                               GPUMemoryAllocator &allocator);
+
     static std::pair<const Shape *, uint>
     build_triangles(const Transform &render_from_object, bool reverse_orientation,
                     const std::vector<Point3f> &points, const std::vector<int> &indices,
                     const std::vector<Normal3f> &normals, const std::vector<Point2f> &uv,
                     GPUMemoryAllocator &allocator);
 
+    static std::pair<const Shape *, uint>
+    build_triangles(const Transform &render_from_object, bool reverse_orientation,
+                    const std::vector<Point3f> &points, const std::vector<Normal3f> &normals,
+                    const SharedBuffers &shared_buffers, GPUMemoryAllocator &allocator);
+
     PBRT_CPU_GPU
     void init(bool _reverse_orientation, const int *_vertex_indices, uint num_indices,
               const Point3f *_p, const Normal3f *_n, const Point2f *_uv) {
@@ -19,6 +19,10 @@ class RGBAlbedoSpectrum {
     PBRT_CPU_GPU
     SampledSpectrum sample(const SampledWavelengths &lambda) const;
 
+    const RGBSigmoidPolynomial &get_rsp() const {
+        return rsp;
+    }
+
   private:
     RGBSigmoidPolynomial rsp;
 };
@@ -27,6 +27,14 @@ class RGBUnboundedSpectrum {
     PBRT_CPU_GPU
     SampledSpectrum sample(const SampledWavelengths &lambda) const;
 
+    FloatType get_scale() const {
+        return scale;
+    }
+
+    const RGBSigmoidPolynomial &get_rsp() const {
+        return rsp;
+    }
+
   private:
     FloatType scale;
     RGBSigmoidPolynomial rsp;
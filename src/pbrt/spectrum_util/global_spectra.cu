@@ -25,10 +25,6 @@ const GlobalSpectra *GlobalSpectra::create(RGBtoSpectrumData::Gamut gamut,
     cie_xyz[2] = Spectrum::create_piecewise_linear_spectrum_from_lambdas_and_values(
         vec_cie_lambdas, vec_cie_z_values, allocator);
 
-    const auto spectrum_cie_illum_d6500 =
-        Spectrum::create_piecewise_linear_spectrum_from_interleaved(CIE_Illum_D6500, true,
-                                                                    cie_xyz[1], allocator);
-
     auto global_spectra = allocator.allocate<GlobalSpectra>();
 
     for (uint idx = 0; idx < 3; ++idx) {
@@ -36,24 +32,52 @@ const GlobalSpectra *GlobalSpectra::create(RGBtoSpectrumData::Gamut gamut,
     }
     global_spectra->cie_y = cie_xyz[1];
 
-    if (gamut == RGBtoSpectrumData::Gamut::sRGB) {
-        auto rgb_to_spectrum_table = allocator.allocate<RGBtoSpectrumData::RGBtoSpectrumTable>();
-        rgb_to_spectrum_table->init("sRGB");
-
-        auto rgb_color_space = allocator.allocate<RGBColorSpace>();
-        rgb_color_space->init(Point2f(0.64, 0.33), Point2f(0.3, 0.6), Point2f(0.15, 0.06),
-                              spectrum_cie_illum_d6500, rgb_to_spectrum_table, cie_xyz);
+    if (gamut == RGBtoSpectrumData::Gamut::XYZ || gamut == RGBtoSpectrumData::Gamut::NO_GAMUT) {
+        printf("\n%s(): color space `%s` not implemented\n", __func__,
+               RGBtoSpectrumData::gamut_name(gamut).c_str());
+        REPORT_FATAL_ERROR();
+    }
 
-        global_spectra->rgb_color_space = rgb_color_space;
+    const auto &definition = RGBtoSpectrumData::get_gamut_definition(gamut);
 
+    const Spectrum *illuminant = nullptr;
+    if (definition.illuminant == RGBtoSpectrumData::cie_d65) {
+        illuminant = Spectrum::create_piecewise_linear_spectrum_from_interleaved(
+            CIE_Illum_D6500, true, cie_xyz[1], allocator);
     } else {
-        REPORT_FATAL_ERROR();
+        // resample the 5nm table the rgb-to-spectrum fit was computed against
+        std::vector<FloatType> interleaved;
+        for (uint idx = 0; idx < RGBtoSpectrumData::CIE_SAMPLES; ++idx) {
+            interleaved.push_back(RGBtoSpectrumData::CIE_LAMBDA_MIN + idx * 5);
+            interleaved.push_back(definition.illuminant[idx]);
+        }
+
+        illuminant = Spectrum::create_piecewise_linear_spectrum_from_interleaved(
+            interleaved, true, cie_xyz[1], allocator);
     }
 
-    const std::chrono::duration<FloatType> duration{std::chrono::system_clock::now() - start};
-    std::cout << std::fixed << std::setprecision(1) << "spectra computing took " << duration.count()
-              << " seconds.\n"
-              << std::flush;
+    auto rgb_to_spectrum_table = allocator.allocate<RGBtoSpectrumData::RGBtoSpectrumTable>();
+    const bool loaded_from_cache = rgb_to_spectrum_table->init(gamut);
+
+    const auto &primaries = definition.primaries;
+
+    auto rgb_color_space = allocator.allocate<RGBColorSpace>();
+    rgb_color_space->init(Point2f(primaries[0][0], primaries[0][1]),
+                          Point2f(primaries[1][0], primaries[1][1]),
+                          Point2f(primaries[2][0], primaries[2][1]), illuminant,
+                          rgb_to_spectrum_table, cie_xyz);
+
+    global_spectra->rgb_color_space = rgb_color_space;
+
+    if (loaded_from_cache) {
+        std::cout << RGBtoSpectrumData::gamut_name(gamut) << " spectra loaded from cache.\n"
+                  << std::flush;
+    } else {
+        const std::chrono::duration<FloatType> duration{std::chrono::system_clock::now() - start};
+        std::cout << std::fixed << std::setprecision(1) << RGBtoSpectrumData::gamut_name(gamut)
+                  << " spectra computing took " << duration.count() << " seconds.\n"
+                  << std::flush;
+    }
 
     return global_spectra;
 }
@@ -1,8 +1,17 @@
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <pbrt/spectrum_util/rgb_to_spectrum_data.h>
+#include <pbrt/spectrum_util/spectrum_constants_cie.h>
 #include <pbrt/util/thread_pool.h>
+#include <unistd.h>
 
 constexpr double RGB2SPEC_EPSILON = 1e-4;
 
+constexpr char CACHE_MAGIC[4] = {'R', 'G', 'B', 'S'};
+constexpr uint32_t CACHE_VERSION = 1;
+
 const double xyz_to_srgb[3][3] = {
     {3.240479, -1.537150, -0.498535},
     {-0.969256, 1.875991, 0.041556},
@@ -15,7 +24,7 @@ const double srgb_to_xyz[3][3] = {
     {0.019334, 0.119193, 0.950227},
 };
 
-[[maybe_unused]] const double xyz_to_xyz[3][3] = {
+const double xyz_to_xyz[3][3] = {
     {1.0, 0.0, 0.0},
     {0.0, 1.0, 0.0},
     {0.0, 0.0, 1.0},
@@ -160,27 +169,68 @@ void cie_lab(double *p, const RGBtoSpectrumBuffer *data) {
     p[2] = 200.0 * (f(Y / Yw) - f(Z / Zw));
 }
 
-void init_tables(RGBtoSpectrumBuffer *data, Gamut gamut) {
-    memset(data->rgb_tbl, 0, sizeof(data->rgb_tbl));
-    memset(data->xyz_whitepoint, 0, sizeof(data->xyz_whitepoint));
+void invert_3x3(const double m[3][3], double out[3][3]) {
+    const double det = m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+                       m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+                       m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
 
-    double h = double(CIE_LAMBDA_MAX - CIE_LAMBDA_MIN) / double(CIE_FINE_SAMPLES - 1);
+    if (std::abs(det) < 1e-12) {
+        throw std::runtime_error("invert_3x3(): singular matrix.");
+    }
 
-    const double *illuminant = nullptr;
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            // cofactor of m[j][i]
+            const int r0 = (j + 1) % 3;
+            const int r1 = (j + 2) % 3;
+            const int c0 = (i + 1) % 3;
+            const int c1 = (i + 2) % 3;
+            out[i][j] = (m[r0][c0] * m[r1][c1] - m[r0][c1] * m[r1][c0]) / det;
+        }
+    }
+}
 
-    switch (gamut) {
-    case Gamut::sRGB: {
-        illuminant = cie_d65;
-        memcpy(data->xyz_to_rgb, xyz_to_srgb, sizeof(double) * 9);
-        memcpy(data->rgb_to_xyz, srgb_to_xyz, sizeof(double) * 9);
-        break;
+// RGB->XYZ maps (1, 1, 1) to the whitepoint (normalized to Y = 1)
+void derive_matrices(RGBtoSpectrumBuffer *data, const double primaries[3][2]) {
+    double P[3][3];
+    for (int c = 0; c < 3; ++c) {
+        const double x = primaries[c][0];
+        const double y = primaries[c][1];
+        P[0][c] = x / y;
+        P[1][c] = 1.0;
+        P[2][c] = (1.0 - x - y) / y;
     }
 
-    default: {
-        throw std::runtime_error("init_tables(): invalid/unsupported gamut.");
+    double inv_P[3][3];
+    invert_3x3(P, inv_P);
+
+    double white[3];
+    for (int k = 0; k < 3; ++k) {
+        white[k] = data->xyz_whitepoint[k] / data->xyz_whitepoint[1];
     }
+
+    for (int c = 0; c < 3; ++c) {
+        const double scale =
+            inv_P[c][0] * white[0] + inv_P[c][1] * white[1] + inv_P[c][2] * white[2];
+        for (int k = 0; k < 3; ++k) {
+            data->rgb_to_xyz[k][c] = P[k][c] * scale;
+        }
     }
 
+    invert_3x3(data->rgb_to_xyz, data->xyz_to_rgb);
+}
+
+void init_tables(RGBtoSpectrumBuffer *data, Gamut gamut) {
+    memset(data->rgb_tbl, 0, sizeof(data->rgb_tbl));
+    memset(data->xyz_whitepoint, 0, sizeof(data->xyz_whitepoint));
+
+    double h = double(CIE_LAMBDA_MAX - CIE_LAMBDA_MIN) / double(CIE_FINE_SAMPLES - 1);
+
+    const double *illuminant =
+        gamut == Gamut::XYZ ? cie_e : get_gamut_definition(gamut).illuminant;
+
+    double weighted_xyz[CIE_FINE_SAMPLES][3];
+
     for (uint i = 0; i < CIE_FINE_SAMPLES; ++i) {
         double lambda = CIE_LAMBDA_MIN + i * h;
 
@@ -200,13 +250,36 @@ void init_tables(RGBtoSpectrumBuffer *data, Gamut gamut) {
 
         data->lambda_tbl[i] = lambda;
         for (int k = 0; k < 3; ++k) {
-            for (int j = 0; j < 3; ++j) {
-                data->rgb_tbl[k][i] += data->xyz_to_rgb[k][j] * xyz[j] * I * weight;
-            }
+            weighted_xyz[i][k] = xyz[k] * I * weight;
+            data->xyz_whitepoint[k] += weighted_xyz[i][k];
         }
+    }
+
+    switch (gamut) {
+    case Gamut::sRGB: {
+        memcpy(data->xyz_to_rgb, xyz_to_srgb, sizeof(double) * 9);
+        memcpy(data->rgb_to_xyz, srgb_to_xyz, sizeof(double) * 9);
+        break;
+    }
 
+    case Gamut::XYZ: {
+        memcpy(data->xyz_to_rgb, xyz_to_xyz, sizeof(double) * 9);
+        memcpy(data->rgb_to_xyz, xyz_to_xyz, sizeof(double) * 9);
+        break;
+    }
+
+    default: {
+        // the remaining gamuts are derived from their primaries and whitepoint
+        derive_matrices(data, get_gamut_definition(gamut).primaries);
+        break;
+    }
+    }
+
+    for (uint i = 0; i < CIE_FINE_SAMPLES; ++i) {
         for (int k = 0; k < 3; ++k) {
-            data->xyz_whitepoint[k] += xyz[k] * I * weight;
+            for (int j = 0; j < 3; ++j) {
+                data->rgb_tbl[k][i] += data->xyz_to_rgb[k][j] * weighted_xyz[i][j];
+            }
         }
     }
 }
@@ -399,12 +472,188 @@ RGBSigmoidPolynomial RGBtoSpectrumTable::operator()(const RGB &rgb) const {
     return RGBSigmoidPolynomial(c[0], c[1], c[2]);
 }
 
-void RGBtoSpectrumTable::init(const std::string &str_gamut) {
-    if (str_gamut != "sRGB") {
-        throw std::runtime_error("compute_spectrum_table_data: only sRGB is implemented");
+// CIE D60 (the ACES white) isn't tabulated: build it from the daylight basis functions the way
+// Spectrum::create_cie_d() does, normalized to unit luminance like the other illuminants
+const double *get_cie_d60() {
+    static const auto d60 = [] {
+        const double cct = 6000.0 * 1.4388 / 1.4380;
+        const double x = -4.607e9 / (cct * cct * cct) + 2.9678e6 / (cct * cct) + 0.09911e3 / cct +
+                         0.244063;
+        const double y = -3 * x * x + 2.870 * x - 0.275;
+
+        const double M = 0.0241 + 0.2562 * x - 0.7341 * y;
+        const double M1 = (-1.3515 - 1.7703 * x + 5.9114 * y) / M;
+        const double M2 = (0.0300 - 31.4424 * x + 30.0717 * y) / M;
+
+        // both tables are sampled every 5nm, the basis functions start at 300nm
+        constexpr int offset = int(CIE_LAMBDA_MIN - 300) / 5;
+
+        std::array<double, CIE_SAMPLES> values;
+        double luminance = 0;
+        for (int idx = 0; idx < CIE_SAMPLES; ++idx) {
+            values[idx] = CIE_S0[idx + offset] + CIE_S1[idx + offset] * M1 +
+                          CIE_S2[idx + offset] * M2;
+            luminance += values[idx] * cie_y[idx];
+        }
+        luminance *= (CIE_LAMBDA_MAX - CIE_LAMBDA_MIN) / (CIE_SAMPLES - 1);
+
+        for (auto &v : values) {
+            v /= luminance;
+        }
+
+        return values;
+    }();
+
+    return d60.data();
+}
+
+const GamutDefinition &get_gamut_definition(Gamut gamut) {
+    static const GamutDefinition srgb = {{{0.64, 0.33}, {0.3, 0.6}, {0.15, 0.06}}, cie_d65};
+    static const GamutDefinition aces2065_1 = {
+        {{0.7347, 0.2653}, {0.0, 1.0}, {0.0001, -0.077}}, get_cie_d60()};
+    // sRGB primaries under the equal-energy white
+    static const GamutDefinition ergb = {{{0.64, 0.33}, {0.3, 0.6}, {0.15, 0.06}}, cie_e};
+    static const GamutDefinition prophoto_rgb = {
+        {{0.7347, 0.2653}, {0.1596, 0.8404}, {0.0366, 0.0001}}, cie_d50};
+    static const GamutDefinition rec2020 = {{{0.708, 0.292}, {0.170, 0.797}, {0.131, 0.046}},
+                                            cie_d65};
+    static const GamutDefinition dci_p3 = {{{0.680, 0.320}, {0.265, 0.690}, {0.150, 0.060}},
+                                           cie_d65};
+
+    switch (gamut) {
+    case Gamut::sRGB: {
+        return srgb;
+    }
+    case Gamut::ProPhotoRGB: {
+        return prophoto_rgb;
+    }
+    case Gamut::ACES2065_1: {
+        return aces2065_1;
+    }
+    case Gamut::REC2020: {
+        return rec2020;
+    }
+    case Gamut::ERGB: {
+        return ergb;
+    }
+    case Gamut::DCI_P3: {
+        return dci_p3;
+    }
+    default: {
+        throw std::runtime_error("get_gamut_definition(): unsupported gamut `" +
+                                 gamut_name(gamut) + "`.");
     }
+    }
+}
 
-    Gamut gamut = Gamut::sRGB;
+std::string gamut_name(Gamut gamut) {
+    switch (gamut) {
+    case Gamut::sRGB: {
+        return "sRGB";
+    }
+    case Gamut::ProPhotoRGB: {
+        return "ProPhotoRGB";
+    }
+    case Gamut::ACES2065_1: {
+        return "ACES2065_1";
+    }
+    case Gamut::REC2020: {
+        return "REC2020";
+    }
+    case Gamut::ERGB: {
+        return "ERGB";
+    }
+    case Gamut::XYZ: {
+        return "XYZ";
+    }
+    case Gamut::DCI_P3: {
+        return "DCI_P3";
+    }
+    default: {
+        return "NO_GAMUT";
+    }
+    }
+}
+
+std::string cache_filename(Gamut gamut) {
+    std::string cache_dir;
+    if (const char *xdg_cache = getenv("XDG_CACHE_HOME"); xdg_cache && *xdg_cache) {
+        cache_dir = std::string(xdg_cache) + "/pbrt-minus";
+    } else if (const char *home = getenv("HOME"); home && *home) {
+        cache_dir = std::string(home) + "/.cache/pbrt-minus";
+    } else {
+        return "";
+    }
+
+    return cache_dir + "/rgb_to_spectrum_" + gamut_name(gamut) + "_" + std::to_string(RES) +
+           ".bin";
+}
+
+bool RGBtoSpectrumTable::read_cache(const std::string &filename, Gamut gamut) {
+    std::ifstream stream(filename, std::ios::binary);
+    if (!stream.is_open()) {
+        return false;
+    }
+
+    std::array<char, 4> magic;
+    uint32_t version = 0;
+    uint32_t res = 0;
+    uint32_t cached_gamut = 0;
+
+    stream.read(magic.data(), magic.size());
+    stream.read(reinterpret_cast<char *>(&version), sizeof(version));
+    stream.read(reinterpret_cast<char *>(&res), sizeof(res));
+    stream.read(reinterpret_cast<char *>(&cached_gamut), sizeof(cached_gamut));
+
+    if (!stream || memcmp(magic.data(), CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+        version != CACHE_VERSION || res != RES || cached_gamut != static_cast<uint32_t>(gamut)) {
+        return false;
+    }
+
+    stream.read(reinterpret_cast<char *>(z_nodes), sizeof(z_nodes));
+    stream.read(reinterpret_cast<char *>(coefficients), sizeof(coefficients));
+
+    // a short read means a truncated (or concurrently written) file
+    return stream.gcount() == sizeof(coefficients) && stream.peek() == EOF;
+}
+
+void RGBtoSpectrumTable::write_cache(const std::string &filename, Gamut gamut) const {
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(filename).parent_path(), error);
+
+    // write aside and rename so that a concurrent reader never sees a partial table
+    const auto tmp_filename = filename + ".tmp" + std::to_string(getpid());
+    {
+        std::ofstream stream(tmp_filename, std::ios::binary | std::ios::trunc);
+        if (!stream.is_open()) {
+            printf("%s(): fail to write `%s`, rgb-to-spectrum table not cached\n", __func__,
+                   tmp_filename.c_str());
+            return;
+        }
+
+        const uint32_t version = CACHE_VERSION;
+        const uint32_t res = RES;
+        const uint32_t cached_gamut = static_cast<uint32_t>(gamut);
+
+        stream.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        stream.write(reinterpret_cast<const char *>(&version), sizeof(version));
+        stream.write(reinterpret_cast<const char *>(&res), sizeof(res));
+        stream.write(reinterpret_cast<const char *>(&cached_gamut), sizeof(cached_gamut));
+        stream.write(reinterpret_cast<const char *>(z_nodes), sizeof(z_nodes));
+        stream.write(reinterpret_cast<const char *>(coefficients), sizeof(coefficients));
+    }
+
+    std::filesystem::rename(tmp_filename, filename, error);
+    if (error) {
+        std::filesystem::remove(tmp_filename, error);
+    }
+}
+
+bool RGBtoSpectrumTable::init(Gamut gamut) {
+    const auto filename = cache_filename(gamut);
+    if (!filename.empty() && read_cache(filename, gamut)) {
+        return true;
+    }
 
     RGBtoSpectrumBuffer rgb_to_spectrum_buffer;
     init_tables(&rgb_to_spectrum_buffer, gamut);
@@ -423,5 +672,11 @@ void RGBtoSpectrumTable::init(const std::string &str_gamut) {
                 compute(coefficients_ptr, j, rgb_to_spectrum_buffer, z_nodes_ptr, l);
             });
     }
+
+    if (!filename.empty()) {
+        write_cache(filename, gamut);
+    }
+
+    return false;
 }
 } // namespace RGBtoSpectrumData
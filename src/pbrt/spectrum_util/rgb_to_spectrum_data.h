@@ -2,6 +2,7 @@
 
 #include <pbrt/spectrum_util/rgb.h>
 #include <pbrt/spectrum_util/rgb_sigmoid_polynomial.h>
+#include <string>
 
 namespace RGBtoSpectrumData {
 
@@ -25,6 +26,16 @@ enum class Gamut {
     NO_GAMUT,
 };
 
+// chromaticities of the red, green and blue primaries plus the white illuminant
+struct GamutDefinition {
+    double primaries[3][2];
+    const double *illuminant;
+};
+
+const GamutDefinition &get_gamut_definition(Gamut gamut);
+
+std::string gamut_name(Gamut gamut);
+
 struct RGBtoSpectrumTable {
     double z_nodes[RES];
     double coefficients[3][RES][RES][RES][3];
@@ -32,7 +43,14 @@ struct RGBtoSpectrumTable {
     PBRT_CPU_GPU
     RGBSigmoidPolynomial operator()(const RGB &rgb) const;
 
-    void init(const std::string &str_gamut);
+    // loads the table from the on-disk cache when available (and returns true), otherwise fits
+    // it and caches it
+    bool init(Gamut gamut);
+
+  private:
+    bool read_cache(const std::string &filename, Gamut gamut);
+
+    void write_cache(const std::string &filename, Gamut gamut) const;
 };
 
 // clang-format off
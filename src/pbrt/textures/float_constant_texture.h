@@ -24,6 +24,10 @@ class FloatConstantTexture {
         return value;
     }
 
+    FloatType get_value() const {
+        return value;
+    }
+
   private:
     FloatType value;
 };
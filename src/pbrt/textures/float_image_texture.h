@@ -22,7 +22,8 @@ class FloatImageTexture : ImageTextureBase {
         // image coordinates are (0,0) in the upper left.
 
         c.st[1] = 1 - c.st[1];
-        auto v = this->scale * mipmap->filter(c.st)[0];
+        auto v =
+            this->scale * mipmap->filter(c.st, Vector2f(c.dsdx, c.dtdx), Vector2f(c.dsdy, c.dtdy))[0];
 
         return invert ? std::max<FloatType>(0, 1 - v) : v;
     }
@@ -1,9 +1,18 @@
+#include <algorithm>
+#include <cstring>
 #include <ext/lodepng/lodepng.h>
+#include <fcntl.h>
 #include <filesystem>
+#include <map>
 #include <pbrt/gpu/gpu_memory_allocator.h>
 #include <pbrt/spectrum_util/color_encoding.h>
 #include <pbrt/spectrum_util/rgb.h>
 #include <pbrt/textures/gpu_image.h>
+#include <pbrt/textures/texture_pool.h>
+#include <pbrt/util/float.h>
+#include <pbrt/util/hash.h>
+#include <pbrt/util/thread_pool.h>
+#include <unistd.h>
 
 // clang-format off
 #define STB_IMAGE_IMPLEMENTATION
@@ -16,6 +25,94 @@
 #undef TINYEXR_IMPLEMENTATION
 // clang-format on
 
+namespace {
+// decoded images shared by every texture and light that references the same file
+// (a process renders a single scene, so entries live as long as its allocator)
+std::map<std::string, const GPUImage *> image_cache;
+
+// MIP pyramids, shared by every texture referencing the same file
+std::map<std::string, std::vector<const GPUImage *>> pyramid_cache;
+
+bool paging_enabled = false;
+
+// levels whose tiles are decoded on demand, indexed by their `paged_idx`
+std::vector<GPUImage *> paged_images;
+
+// tile cache file of each paged image, indexed by `tile_file_idx`: files are only opened for
+// a batch of reads, a scene may reference more images than a process may keep open
+std::vector<std::string> tile_cache_filenames;
+
+uint num_tile_cache_hits = 0;
+
+// tile cache file: header, resolution of each level, then the texels of each level in the tiled
+// layout of GPUImage, so a tile is a contiguous range of the file
+constexpr char TILE_CACHE_MAGIC[8] = "pbrtile";
+constexpr uint32_t TILE_CACHE_VERSION = 1;
+
+struct TileCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t tile_size;
+    uint32_t pixel_format;
+    uint32_t num_levels;
+};
+
+// keyed by the path, size and modification time of the source, so an edited image is decoded again
+std::string tile_cache_filename(const std::string &canonical_path) {
+    std::string cache_dir;
+    if (const char *xdg_cache = getenv("XDG_CACHE_HOME"); xdg_cache && *xdg_cache) {
+        cache_dir = std::string(xdg_cache) + "/pbrt-minus";
+    } else if (const char *home = getenv("HOME"); home && *home) {
+        cache_dir = std::string(home) + "/.cache/pbrt-minus";
+    } else {
+        cache_dir = (std::filesystem::temp_directory_path() / "pbrt-minus").string();
+    }
+
+    const auto key = canonical_path + ":" +
+                     std::to_string(std::filesystem::file_size(canonical_path)) + ":" +
+                     std::to_string(std::filesystem::last_write_time(canonical_path)
+                                        .time_since_epoch()
+                                        .count());
+    const auto hash =
+        HIDDEN::MurmurHash64A(reinterpret_cast<const unsigned char *>(key.data()), key.size(), 0);
+
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(hash));
+
+    return cache_dir + "/texture_tiles/" + name + ".tiles";
+}
+
+bool read_at(const int file, void *dst, const size_t size, size_t offset) {
+    auto ptr = static_cast<char *>(dst);
+    for (size_t done = 0; done < size;) {
+        const auto num = pread(file, ptr + done, size - done, offset + done);
+        if (num <= 0) {
+            return false;
+        }
+        done += num;
+    }
+
+    return true;
+}
+
+// -1 when the cache is missing, stale or written by another version
+int open_tile_cache(const std::string &filename, TileCacheHeader &header, const uint tile_size) {
+    const int file = open(filename.c_str(), O_RDONLY);
+    if (file < 0) {
+        return -1;
+    }
+
+    if (!read_at(file, &header, sizeof(header), 0) ||
+        memcmp(header.magic, TILE_CACHE_MAGIC, sizeof(TILE_CACHE_MAGIC)) != 0 ||
+        header.version != TILE_CACHE_VERSION || header.tile_size != tile_size) {
+        close(file);
+        return -1;
+    }
+
+    return file;
+}
+} // namespace
+
 PBRT_CPU_GPU
 Point2i remap_pixel_coord(const Point2i p, const Point2i resolution, WrapMode2D wrap_mode) {
     if (wrap_mode[0] == WrapMode::OctahedralSphere || wrap_mode[1] == WrapMode::OctahedralSphere) {
@@ -60,6 +157,10 @@ Point2i remap_pixel_coord(const Point2i p, const Point2i resolution, WrapMode2D
             coord[c] = mod(coord[c], resolution[c]);
             break;
         }
+        case (WrapMode::Clamp): {
+            coord[c] = clamp(coord[c], 0, resolution[c] - 1);
+            break;
+        }
         default: {
             REPORT_FATAL_ERROR();
         }
@@ -71,9 +172,21 @@ Point2i remap_pixel_coord(const Point2i p, const Point2i resolution, WrapMode2D
 
 const GPUImage *GPUImage::create_from_file(const std::string &filename,
                                            GPUMemoryAllocator &allocator) {
+    const auto canonical_path = std::filesystem::weakly_canonical(filename).string();
+    if (const auto cached = image_cache.find(canonical_path); cached != image_cache.end()) {
+        return cached->second;
+    }
+
+    const auto image = decode(filename, allocator);
+    image_cache[canonical_path] = image;
+
+    return image;
+}
+
+GPUImage *GPUImage::decode(const std::string &filename, GPUMemoryAllocator &allocator) {
     auto image = allocator.allocate<GPUImage>();
-    image->pixels = nullptr;
     image->resolution = Point2i(0, 0);
+    image->clear_storage();
 
     const auto file_extension = std::filesystem::path(filename).extension();
 
@@ -94,13 +207,211 @@ const GPUImage *GPUImage::create_from_file(const std::string &filename,
         REPORT_FATAL_ERROR();
     }
 
-    if (image->pixels == nullptr || image->resolution == Point2i(0, 0)) {
+    if (image->resolution == Point2i(0, 0) ||
+        (image->pixels_u256 == nullptr && image->pixels_half == nullptr &&
+         image->pixels_float == nullptr)) {
         REPORT_FATAL_ERROR();
     }
 
     return image;
 }
 
+const std::vector<const GPUImage *> &
+GPUImage::create_mip_pyramid(const std::string &filename, GPUMemoryAllocator &allocator) {
+    const auto canonical_path = std::filesystem::weakly_canonical(filename).string();
+    if (const auto cached = pyramid_cache.find(canonical_path); cached != pyramid_cache.end()) {
+        return cached->second;
+    }
+
+    std::vector<const GPUImage *> pyramid;
+    if (paging_enabled) {
+        pyramid = create_paged_pyramid(canonical_path, allocator);
+    } else {
+        pyramid = {create_from_file(filename, allocator)};
+        while (pyramid.back()->get_resolution() != Point2i(1, 1)) {
+            pyramid.push_back(pyramid.back()->downsample(allocator));
+        }
+    }
+
+    pyramid_cache[canonical_path] = pyramid;
+    return pyramid_cache.at(canonical_path);
+}
+
+std::vector<const GPUImage *> GPUImage::create_paged_pyramid(const std::string &canonical_path,
+                                                             GPUMemoryAllocator &allocator) {
+    const auto filename = tile_cache_filename(canonical_path);
+
+    TileCacheHeader header;
+    int file = open_tile_cache(filename, header, TILE_SIZE);
+
+    if (file >= 0) {
+        num_tile_cache_hits += 1;
+    } else {
+        // the decoded texels only live until their tiles are written
+        GPUMemoryAllocator scratch_allocator;
+
+        std::vector<const GPUImage *> levels = {decode(canonical_path, scratch_allocator)};
+        while (levels.back()->get_resolution() != Point2i(1, 1)) {
+            levels.push_back(levels.back()->downsample(scratch_allocator));
+        }
+
+        std::error_code error;
+        std::filesystem::create_directories(std::filesystem::path(filename).parent_path(), error);
+
+        // write aside and rename so that a concurrent reader never sees a partial cache
+        const auto tmp_filename = filename + ".tmp" + std::to_string(getpid());
+        {
+            std::ofstream stream(tmp_filename, std::ios::binary | std::ios::trunc);
+            if (!stream.is_open()) {
+                printf("\n%s(): fail to write tile cache `%s`\n", __func__, tmp_filename.c_str());
+                REPORT_FATAL_ERROR();
+            }
+
+            memcpy(header.magic, TILE_CACHE_MAGIC, sizeof(TILE_CACHE_MAGIC));
+            header.version = TILE_CACHE_VERSION;
+            header.tile_size = TILE_SIZE;
+            header.pixel_format = static_cast<uint32_t>(levels[0]->pixel_format);
+            header.num_levels = levels.size();
+            stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+            for (const auto level : levels) {
+                const int32_t level_resolution[2] = {level->resolution.x, level->resolution.y};
+                stream.write(reinterpret_cast<const char *>(level_resolution),
+                             sizeof(level_resolution));
+            }
+
+            for (const auto level : levels) {
+                const void *texels = level->pixels_u256 != nullptr
+                                         ? (const void *)level->pixels_u256
+                                     : level->pixels_half != nullptr
+                                         ? (const void *)level->pixels_half
+                                         : (const void *)level->pixels_float;
+                stream.write(static_cast<const char *>(texels), level->get_storage_size());
+            }
+
+            if (!stream) {
+                printf("\n%s(): fail to write tile cache `%s`\n", __func__, tmp_filename.c_str());
+                REPORT_FATAL_ERROR();
+            }
+        }
+
+        std::filesystem::rename(tmp_filename, filename, error);
+        if (error) {
+            std::filesystem::remove(tmp_filename, error);
+        }
+
+        file = open_tile_cache(filename, header, TILE_SIZE);
+        if (file < 0) {
+            printf("\n%s(): fail to read tile cache `%s`\n", __func__, filename.c_str());
+            REPORT_FATAL_ERROR();
+        }
+    }
+
+    std::vector<int32_t> level_resolutions(header.num_levels * 2);
+    if (!read_at(file, level_resolutions.data(), level_resolutions.size() * sizeof(int32_t),
+                 sizeof(header))) {
+        printf("\n%s(): tile cache `%s` is truncated\n", __func__, filename.c_str());
+        REPORT_FATAL_ERROR();
+    }
+
+    const auto pixel_format = static_cast<PixelFormat>(header.pixel_format);
+
+    const FloatType *srgb_to_linear = nullptr;
+    if (pixel_format == PixelFormat::U256) {
+        SRGBColorEncoding encoding;
+        auto lut = allocator.allocate<FloatType>(256);
+        for (uint idx = 0; idx < 256; ++idx) {
+            lut[idx] = encoding.to_linear(idx);
+        }
+        srgb_to_linear = lut;
+    }
+
+    const uint tile_file_idx = tile_cache_filenames.size();
+    tile_cache_filenames.push_back(filename);
+
+    std::vector<const GPUImage *> pyramid;
+    size_t offset = sizeof(header) + level_resolutions.size() * sizeof(int32_t);
+    for (uint level = 0; level < header.num_levels; ++level) {
+        auto image = allocator.allocate<GPUImage>();
+        image->clear_storage();
+        image->set_layout(Point2i(level_resolutions[level * 2], level_resolutions[level * 2 + 1]));
+        image->pixel_format = pixel_format;
+        image->srgb_to_linear = srgb_to_linear;
+        image->tile_file_idx = tile_file_idx;
+        image->tile_file_offset = offset;
+
+        if (image->tile_size == TILE_SIZE) {
+            image->num_tiles = image->num_stored_texels() / (TILE_SIZE * TILE_SIZE);
+
+            auto tile_slots = allocator.allocate<uint>(image->num_tiles);
+            auto tile_requested = allocator.allocate<uint>(image->num_tiles);
+            std::fill(tile_slots, tile_slots + image->num_tiles, TexturePool::NOT_RESIDENT);
+            std::fill(tile_requested, tile_requested + image->num_tiles, 0);
+            image->tile_slots = tile_slots;
+            image->tile_requested = tile_requested;
+
+            image->paged_idx = paged_images.size();
+            paged_images.push_back(image);
+
+        } else {
+            // levels smaller than a tile are few texels: they stay resident
+            auto texels = allocator.allocate<uint8_t>(image->get_storage_size());
+            if (!read_at(file, texels, image->get_storage_size(), offset)) {
+                printf("\n%s(): tile cache `%s` is truncated\n", __func__, filename.c_str());
+                REPORT_FATAL_ERROR();
+            }
+
+            image->pixels_u256 = pixel_format == PixelFormat::U256 ? texels : nullptr;
+            image->pixels_half =
+                pixel_format == PixelFormat::Half ? reinterpret_cast<Half *>(texels) : nullptr;
+            image->pixels_float =
+                pixel_format == PixelFormat::Float ? reinterpret_cast<float *>(texels) : nullptr;
+        }
+
+        offset += image->get_storage_size();
+        pyramid.push_back(image);
+    }
+    close(file);
+
+    return pyramid;
+}
+
+void GPUImage::enable_paging() {
+    paging_enabled = true;
+}
+
+TexturePool *GPUImage::build_texture_pool(const size_t budget_bytes,
+                                          GPUMemoryAllocator &allocator) {
+    printf("texture tile cache: %u of %zu images already tiled on disk\n", num_tile_cache_hits,
+           pyramid_cache.size());
+
+    if (paged_images.empty()) {
+        return nullptr;
+    }
+
+    return TexturePool::create(budget_bytes, paged_images, allocator);
+}
+
+int GPUImage::open_tile_file() const {
+    const auto &filename = tile_cache_filenames[tile_file_idx];
+
+    const int file = open(filename.c_str(), O_RDONLY);
+    if (file < 0) {
+        printf("\n%s(): fail to open tile cache `%s`\n", __func__, filename.c_str());
+        REPORT_FATAL_ERROR();
+    }
+
+    return file;
+}
+
+void GPUImage::read_tile(const int file, const uint tile_idx, void *dst) const {
+    const auto size = get_tile_storage_size();
+    if (!read_at(file, dst, size, tile_file_offset + tile_idx * size)) {
+        printf("\n%s(): fail to read tile %u from the tile cache\n", __func__, tile_idx);
+        REPORT_FATAL_ERROR();
+    }
+}
+
 void GPUImage::init_exr(const std::string &filename, GPUMemoryAllocator &allocator) {
     float *out; // width * height * RGBA
     int width;
@@ -114,19 +425,47 @@ void GPUImage::init_exr(const std::string &filename, GPUMemoryAllocator &allocat
         exit(1);
     }
 
-    auto gpu_pixels = allocator.allocate<RGB>(width * height);
+    const uint num_pixels = width * height;
+
+    // keep half precision unless some texel falls outside its finite range
+    bool fit_in_half = true;
+    for (uint idx = 0; idx < num_pixels && fit_in_half; ++idx) {
+        for (uint c = 0; c < 3; ++c) {
+            const auto val = out[idx * 4 + c];
+            if (!std::isfinite(val) || std::abs(val) > 65504) {
+                fit_in_half = false;
+                break;
+            }
+        }
+    }
+
+    set_layout(Point2i(width, height));
 
-    for (uint idx = 0; idx < width * height; ++idx) {
-        auto r = out[idx * 4 + 0];
-        auto g = out[idx * 4 + 1];
-        auto b = out[idx * 4 + 2];
-        // auto alpha = out[idx * 4 + 3];
+    if (fit_in_half) {
+        auto gpu_pixels = allocator.allocate<Half>(num_stored_texels() * 3);
+        for (uint idx = 0; idx < num_pixels; ++idx) {
+            const auto offset = texel_offset(Point2i(idx % width, idx / width));
+            for (uint c = 0; c < 3; ++c) {
+                gpu_pixels[offset * 3 + c] = Half(out[idx * 4 + c]);
+            }
+        }
 
-        gpu_pixels[idx] = RGB(r, g, b);
+        pixel_format = PixelFormat::Half;
+        pixels_half = gpu_pixels;
+    } else {
+        auto gpu_pixels = allocator.allocate<float>(num_stored_texels() * 3);
+        for (uint idx = 0; idx < num_pixels; ++idx) {
+            const auto offset = texel_offset(Point2i(idx % width, idx / width));
+            for (uint c = 0; c < 3; ++c) {
+                gpu_pixels[offset * 3 + c] = out[idx * 4 + c];
+            }
+        }
+
+        pixel_format = PixelFormat::Float;
+        pixels_float = gpu_pixels;
     }
 
-    resolution = Point2i(width, height);
-    pixels = gpu_pixels;
+    free(out);
 }
 
 void GPUImage::init_pfm(const std::string &filename, GPUMemoryAllocator &allocator) {
@@ -180,22 +519,22 @@ void GPUImage::init_pfm(const std::string &filename, GPUMemoryAllocator &allocat
         }
     }
 
-    auto gpu_pixels = allocator.allocate<RGB>(width * height);
+    set_layout(Point2i(width, height));
+
+    auto gpu_pixels = allocator.allocate<float>(num_stored_texels() * 3);
     for (uint x = 0; x < width; ++x) {
         for (uint y = 0; y < height; ++y) {
             const auto pfm_idx = (width - 1 - y) * width + x;
-            const auto image_idx = y * width + x;
+            const auto offset = texel_offset(Point2i(x, y));
 
-            auto r = image[pfm_idx * 3 + 0];
-            auto g = image[pfm_idx * 3 + 1];
-            auto b = image[pfm_idx * 3 + 2];
-
-            gpu_pixels[image_idx] = RGB(r, g, b);
+            for (uint c = 0; c < 3; ++c) {
+                gpu_pixels[offset * 3 + c] = image[pfm_idx * 3 + c];
+            }
         }
     }
 
-    resolution = Point2i(width, height);
-    pixels = gpu_pixels;
+    pixel_format = PixelFormat::Float;
+    pixels_float = gpu_pixels;
 }
 
 void GPUImage::init_png(const std::string &filename, GPUMemoryAllocator &allocator) {
@@ -211,24 +550,7 @@ void GPUImage::init_png(const std::string &filename, GPUMemoryAllocator &allocat
     // the pixels are now in the vector "image", 4 bytes per pixel, ordered RGBARGBA..., use it as
     // texture,
 
-    auto gpu_pixels = allocator.allocate<RGB>(width * height);
-
-    SRGBColorEncoding encoding;
-    for (uint x = 0; x < width; ++x) {
-        for (uint y = 0; y < height; ++y) {
-            uint idx = y * width + x;
-
-            const auto r = rgba_pixels[idx * 4 + 0];
-            const auto g = rgba_pixels[idx * 4 + 1];
-            const auto b = rgba_pixels[idx * 4 + 2];
-
-            gpu_pixels[idx] =
-                RGB(encoding.to_linear(r), encoding.to_linear(g), encoding.to_linear(b));
-        }
-    }
-
-    resolution = Point2i(width, height);
-    pixels = gpu_pixels;
+    init_u256(rgba_pixels.data(), 4, Point2i(width, height), allocator);
 }
 
 void GPUImage::init_tga(const std::string &filename, GPUMemoryAllocator &allocator) {
@@ -248,26 +570,134 @@ void GPUImage::init_tga(const std::string &filename, GPUMemoryAllocator &allocat
         REPORT_FATAL_ERROR();
     }
 
+    init_u256(img, channels, Point2i(width, height), allocator);
+
+    stbi_image_free(img);
+}
+
+void GPUImage::init_u256(const uint8_t *data, const uint channels, const Point2i _resolution,
+                         GPUMemoryAllocator &allocator) {
+    const uint num_pixels = _resolution.x * _resolution.y;
+
+    set_layout(_resolution);
+
+    auto gpu_pixels = allocator.allocate<uint8_t>(num_stored_texels() * 3);
+    for (uint idx = 0; idx < num_pixels; ++idx) {
+        const auto offset = texel_offset(Point2i(idx % _resolution.x, idx / _resolution.x));
+        for (uint c = 0; c < 3; ++c) {
+            gpu_pixels[offset * 3 + c] = data[idx * channels + c];
+        }
+    }
+
     SRGBColorEncoding encoding;
-    auto gpu_pixels = allocator.allocate<RGB>(width * height);
-    for (uint idx = 0; idx < width * height; ++idx) {
-        const auto r = img[idx * channels + 0];
-        const auto g = img[idx * channels + 1];
-        const auto b = img[idx * channels + 2];
+    auto lut = allocator.allocate<FloatType>(256);
+    for (uint idx = 0; idx < 256; ++idx) {
+        lut[idx] = encoding.to_linear(idx);
+    }
+
+    pixel_format = PixelFormat::U256;
+    pixels_u256 = gpu_pixels;
+    srgb_to_linear = lut;
+}
+
+void GPUImage::clear_storage() {
+    pixels_u256 = nullptr;
+    pixels_half = nullptr;
+    pixels_float = nullptr;
+    srgb_to_linear = nullptr;
+
+    texture_pool = nullptr;
+    tile_slots = nullptr;
+    tile_requested = nullptr;
+    num_tiles = 0;
+    paged_idx = 0;
+
+    tile_file_idx = 0;
+    tile_file_offset = 0;
+}
+
+void GPUImage::set_layout(const Point2i _resolution) {
+    resolution = _resolution;
+    tile_size = resolution.x >= TILE_SIZE && resolution.y >= TILE_SIZE ? TILE_SIZE : 1;
+}
 
-        gpu_pixels[idx] = RGB(encoding.to_linear(r), encoding.to_linear(g), encoding.to_linear(b));
+uint GPUImage::num_stored_texels() const {
+    if (tile_size == 1) {
+        return resolution.x * resolution.y;
     }
 
-    stbi_image_free(img);
+    return divide_and_ceil<uint>(resolution.x, TILE_SIZE) *
+           divide_and_ceil<uint>(resolution.y, TILE_SIZE) * TILE_SIZE * TILE_SIZE;
+}
+
+size_t GPUImage::get_storage_size() const {
+    switch (pixel_format) {
+    case PixelFormat::U256: {
+        return sizeof(uint8_t) * 3 * num_stored_texels();
+    }
+
+    case PixelFormat::Half: {
+        return sizeof(Half) * 3 * num_stored_texels();
+    }
+
+    case PixelFormat::Float: {
+        return sizeof(float) * 3 * num_stored_texels();
+    }
+    }
+
+    REPORT_FATAL_ERROR();
+    return 0;
+}
+
+size_t GPUImage::get_tile_storage_size() const {
+    return get_storage_size() / num_stored_texels() * TILE_SIZE * TILE_SIZE;
+}
+
+PBRT_CPU_GPU
+RGB GPUImage::get_texel(const Point2i p) const {
+    uint idx = texel_offset(p);
+
+    if (tile_slots != nullptr) {
+        constexpr uint tile_texels = TILE_SIZE * TILE_SIZE;
+        const uint tile_idx = idx / tile_texels;
+
+        const uint slot = tile_slots[tile_idx];
+        if (slot == TexturePool::NOT_RESIDENT) {
+            // the caller runs this lookup again once the tile is loaded
+            texture_pool->request_tile(this, tile_idx);
+            return RGB(0, 0, 0);
+        }
+
+        texture_pool->touch(pixel_format, slot);
+        idx = slot * tile_texels + idx % tile_texels;
+    }
+
+    switch (pixel_format) {
+    case PixelFormat::U256: {
+        return RGB(srgb_to_linear[pixels_u256[idx * 3 + 0]],
+                   srgb_to_linear[pixels_u256[idx * 3 + 1]],
+                   srgb_to_linear[pixels_u256[idx * 3 + 2]]);
+    }
+
+    case PixelFormat::Half: {
+        return RGB(float(pixels_half[idx * 3 + 0]), float(pixels_half[idx * 3 + 1]),
+                   float(pixels_half[idx * 3 + 2]));
+    }
+
+    case PixelFormat::Float: {
+        return RGB(pixels_float[idx * 3 + 0], pixels_float[idx * 3 + 1],
+                   pixels_float[idx * 3 + 2]);
+    }
+    }
 
-    resolution = Point2i(width, height);
-    pixels = gpu_pixels;
+    REPORT_FATAL_ERROR();
+    return RGB(NAN, NAN, NAN);
 }
 
 PBRT_CPU_GPU
 RGB GPUImage::fetch_pixel(const Point2i _p, WrapMode2D wrap_mode) const {
     auto p = remap_pixel_coord(_p, resolution, wrap_mode);
-    return pixels[p.y * resolution.x + p.x];
+    return get_texel(p);
 }
 
 PBRT_CPU_GPU
@@ -294,3 +724,76 @@ RGB GPUImage::bilerp(const Point2f p, const WrapMode2D wrap) const {
     return (1.0 - dx) * (1.0 - dy) * v[0] + dx * (1.0 - dy) * v[1] + (1.0 - dx) * dy * v[2] +
            dx * dy * v[3];
 }
+
+const GPUImage *GPUImage::downsample(GPUMemoryAllocator &allocator) const {
+    const Point2i next_resolution(std::max(1, (resolution.x + 1) / 2),
+                                  std::max(1, (resolution.y + 1) / 2));
+    auto image = allocator.allocate<GPUImage>();
+    image->clear_storage();
+    image->set_layout(next_resolution);
+    image->pixel_format = pixel_format;
+    image->srgb_to_linear = srgb_to_linear;
+
+    uint8_t *next_u256 = nullptr;
+    Half *next_half = nullptr;
+    float *next_float = nullptr;
+
+    switch (pixel_format) {
+    case PixelFormat::U256: {
+        next_u256 = allocator.allocate<uint8_t>(image->num_stored_texels() * 3);
+        image->pixels_u256 = next_u256;
+        break;
+    }
+
+    case PixelFormat::Half: {
+        next_half = allocator.allocate<Half>(image->num_stored_texels() * 3);
+        image->pixels_half = next_half;
+        break;
+    }
+
+    case PixelFormat::Float: {
+        next_float = allocator.allocate<float>(image->num_stored_texels() * 3);
+        image->pixels_float = next_float;
+        break;
+    }
+    }
+
+    ThreadPool thread_pool;
+    thread_pool.parallel_execute(0, next_resolution.y, [&](int y) {
+        SRGBColorEncoding encoding;
+
+        for (int x = 0; x < next_resolution.x; ++x) {
+            RGB sum(0, 0, 0);
+            for (int dy = 0; dy < 2; ++dy) {
+                for (int dx = 0; dx < 2; ++dx) {
+                    const int src_x = std::min(x * 2 + dx, resolution.x - 1);
+                    const int src_y = std::min(y * 2 + dy, resolution.y - 1);
+                    sum += get_texel(Point2i(src_x, src_y));
+                }
+            }
+            const auto average = sum / 4;
+
+            const uint idx = image->texel_offset(Point2i(x, y));
+            for (uint c = 0; c < 3; ++c) {
+                switch (pixel_format) {
+                case PixelFormat::U256: {
+                    next_u256[idx * 3 + c] = encoding.from_linear(average[c]);
+                    break;
+                }
+
+                case PixelFormat::Half: {
+                    next_half[idx * 3 + c] = Half(average[c]);
+                    break;
+                }
+
+                case PixelFormat::Float: {
+                    next_float[idx * 3 + c] = average[c];
+                    break;
+                }
+                }
+            }
+        }
+    });
+
+    return image;
+}
@@ -3,9 +3,12 @@
 #include <pbrt/euclidean_space/point2.h>
 #include <pbrt/gpu/macro.h>
 #include <string>
+#include <vector>
 
 class GPUMemoryAllocator;
+class Half;
 class RGB;
+class TexturePool;
 
 enum class WrapMode {
     Black,
@@ -87,10 +90,86 @@ class GPUImage {
 
     PBRT_CPU_GPU RGB bilerp(Point2f p, WrapMode2D wrap) const;
 
+    // box-filtered copy at half resolution (rounded up), stored in the same pixel format
+    const GPUImage *downsample(GPUMemoryAllocator &allocator) const;
+
+    // every MIP level of the file down to 1x1, shared by the textures referencing it
+    static const std::vector<const GPUImage *> &create_mip_pyramid(const std::string &filename,
+                                                                   GPUMemoryAllocator &allocator);
+
+    // from now on, MIP levels of at least one tile are paged: their tiles are written once to the
+    // on-disk tile cache and only decoded into a TexturePool slot when a lookup first needs them
+    static void enable_paging();
+
+    // the pool holding up to `budget_bytes` of decoded tiles of every paged level,
+    // nullptr when nothing was paged
+    static TexturePool *build_texture_pool(size_t budget_bytes, GPUMemoryAllocator &allocator);
+
   private:
+    friend class TexturePool;
+
+    static constexpr uint TILE_SIZE = 32;
+
     Point2i resolution;
+    PixelFormat pixel_format;
+
+    // texels are grouped in TILE_SIZE x TILE_SIZE tiles so that a memory page holds a compact
+    // image region, images smaller than a tile are stored in scanline order (tile_size = 1)
+    uint tile_size;
+
+    // 3 channels per texel, only the array matching `pixel_format` is allocated
+    const uint8_t *pixels_u256; // sRGB encoded, decoded through `srgb_to_linear`
+    const Half *pixels_half;
+    const float *pixels_float;
+
+    const FloatType *srgb_to_linear;
+
+    // paged levels only (nullptr otherwise): `pixels_*` point to the slots of `texture_pool` and
+    // `tile_slots` maps a tile to its slot, TexturePool::NOT_RESIDENT until it is first loaded
+    TexturePool *texture_pool;
+    uint *tile_slots;
+    uint *tile_requested;
+    uint num_tiles;
+    uint paged_idx;
+
+    // host side: the tile cache file of this level and where its texels start in it
+    uint tile_file_idx;
+    size_t tile_file_offset;
+
+    // no texels, not paged
+    void clear_storage();
+
+    void set_layout(Point2i _resolution);
+
+    uint num_stored_texels() const;
 
-    const RGB *pixels;
+    size_t get_storage_size() const;
+
+    size_t get_tile_storage_size() const;
+
+    // host side: open the tile cache file of a paged level, closed by the caller after its reads
+    int open_tile_file() const;
+
+    // host side: copy a tile of a paged level from its open tile cache file into `dst`
+    void read_tile(int file, uint tile_idx, void *dst) const;
+
+    PBRT_CPU_GPU
+    uint texel_offset(Point2i p) const {
+        if (tile_size == 1) {
+            return p.y * resolution.x + p.x;
+        }
+
+        const uint tiles_per_row = (resolution.x + TILE_SIZE - 1) / TILE_SIZE;
+        const uint tile_idx = (p.y / TILE_SIZE) * tiles_per_row + p.x / TILE_SIZE;
+
+        return tile_idx * TILE_SIZE * TILE_SIZE + (p.y % TILE_SIZE) * TILE_SIZE + p.x % TILE_SIZE;
+    }
+
+    PBRT_CPU_GPU
+    RGB get_texel(Point2i p) const;
+
+    void init_u256(const uint8_t *data, uint channels, Point2i _resolution,
+                   GPUMemoryAllocator &allocator);
 
     void init_exr(const std::string &filename, GPUMemoryAllocator &allocator);
 
@@ -99,4 +178,9 @@ class GPUImage {
     void init_png(const std::string &filename, GPUMemoryAllocator &allocator);
 
     void init_tga(const std::string &filename, GPUMemoryAllocator &allocator);
+
+    static GPUImage *decode(const std::string &filename, GPUMemoryAllocator &allocator);
+
+    static std::vector<const GPUImage *> create_paged_pyramid(const std::string &canonical_path,
+                                                              GPUMemoryAllocator &allocator);
 };
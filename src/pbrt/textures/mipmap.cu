@@ -0,0 +1,150 @@
+#include <pbrt/textures/mipmap.h>
+#include <pbrt/util/math.h>
+
+void MIPMap::init(const ParameterDictionary &parameters, GPUMemoryAllocator &allocator) {
+    auto max_anisotropy = parameters.get_float("maxanisotropy", 8.0);
+    auto filter_string = parameters.get_one_string("filter", "bilinear");
+
+    options = MIPMapFilterOptions{
+        .filter = parse_filter_function(filter_string),
+        .max_anisotropy = max_anisotropy,
+    };
+
+    auto wrap_string = parameters.get_one_string("wrap", "repeat");
+    wrap_mode = parse_wrap_mode(wrap_string);
+
+    auto image_path = parameters.root + "/" + parameters.get_one_string("filename");
+    const auto &pyramid = GPUImage::create_mip_pyramid(image_path, allocator);
+
+    auto gpu_levels = allocator.allocate<const GPUImage *>(pyramid.size());
+    for (uint idx = 0; idx < pyramid.size(); ++idx) {
+        gpu_levels[idx] = pyramid[idx];
+    }
+
+    levels = gpu_levels;
+    num_levels = pyramid.size();
+}
+
+PBRT_CPU_GPU
+RGB MIPMap::filter(const Point2f st, Vector2f dst0, Vector2f dst1) const {
+    if (options.filter != FilterFunction::EWA) {
+        const FloatType width =
+            2 * std::max(std::max(std::abs(dst0[0]), std::abs(dst0[1])),
+                         std::max(std::abs(dst1[0]), std::abs(dst1[1])));
+
+        // Compute MIP Map level for _width_ and handle very wide filter
+        const FloatType level = num_levels - 1 + std::log2(std::max<FloatType>(width, 1e-8));
+        if (level >= num_levels - 1) {
+            return texel(num_levels - 1, Point2i(0, 0));
+        }
+
+        const uint i_level = std::max(0, int(std::floor(level)));
+
+        switch (options.filter) {
+        case FilterFunction::Point: {
+            const auto resolution = levels[i_level]->get_resolution();
+            const Point2i sti(std::round(st[0] * resolution[0] - 0.5),
+                              std::round(st[1] * resolution[1] - 0.5));
+            return texel(i_level, sti);
+        }
+
+        case FilterFunction::Bilinear: {
+            return bilerp(i_level, st);
+        }
+
+        case FilterFunction::Trilinear: {
+            if (i_level == 0) {
+                return bilerp(0, st);
+            }
+
+            const FloatType delta = level - i_level;
+            return (1 - delta) * bilerp(i_level, st) + delta * bilerp(i_level + 1, st);
+        }
+        }
+
+        REPORT_FATAL_ERROR();
+        return {};
+    }
+
+    // EWA: make dst0 the major axis and bound the eccentricity by max_anisotropy
+    if (dst0.length_squared() < dst1.length_squared()) {
+        const auto tmp = dst0;
+        dst0 = dst1;
+        dst1 = tmp;
+    }
+
+    const FloatType longer_length = std::sqrt(dst0.length_squared());
+    FloatType shorter_length = std::sqrt(dst1.length_squared());
+
+    if (shorter_length * options.max_anisotropy < longer_length && shorter_length > 0) {
+        const FloatType scale = longer_length / (shorter_length * options.max_anisotropy);
+        dst1 = Vector2f(dst1[0] * scale, dst1[1] * scale);
+        shorter_length *= scale;
+    }
+
+    if (shorter_length == 0) {
+        return bilerp(0, st);
+    }
+
+    const FloatType lod = std::max<FloatType>(0, num_levels - 1 + std::log2(shorter_length));
+    const uint i_lod = std::floor(lod);
+
+    const FloatType delta = lod - i_lod;
+    return (1 - delta) * ewa(i_lod, st, dst0, dst1) + delta * ewa(i_lod + 1, st, dst0, dst1);
+}
+
+PBRT_CPU_GPU
+RGB MIPMap::ewa(const uint level, const Point2f _st, Vector2f dst0, Vector2f dst1) const {
+    if (level >= num_levels) {
+        return texel(num_levels - 1, Point2i(0, 0));
+    }
+
+    // Convert EWA coordinates to appropriate scale for level
+    const auto resolution = levels[level]->get_resolution();
+    const Point2f st(_st[0] * resolution[0] - 0.5, _st[1] * resolution[1] - 0.5);
+    dst0 = Vector2f(dst0[0] * resolution[0], dst0[1] * resolution[1]);
+    dst1 = Vector2f(dst1[0] * resolution[0], dst1[1] * resolution[1]);
+
+    // Find ellipse coefficients that bound EWA filter region
+    FloatType A = sqr(dst0[1]) + sqr(dst1[1]) + 1;
+    FloatType B = -2 * (dst0[0] * dst0[1] + dst1[0] * dst1[1]);
+    FloatType C = sqr(dst0[0]) + sqr(dst1[0]) + 1;
+    const FloatType inv_f = 1 / (A * C - sqr(B) * 0.25);
+    A *= inv_f;
+    B *= inv_f;
+    C *= inv_f;
+
+    // Compute the ellipse's $(s,t)$ bounding box in texture space
+    const FloatType det = -sqr(B) + 4 * A * C;
+    const FloatType inv_det = 1 / det;
+    const FloatType u_sqrt = safe_sqrt(det * C);
+    const FloatType v_sqrt = safe_sqrt(A * det);
+
+    const int s0 = std::ceil(st[0] - 2 * inv_det * u_sqrt);
+    const int s1 = std::floor(st[0] + 2 * inv_det * u_sqrt);
+    const int t0 = std::ceil(st[1] - 2 * inv_det * v_sqrt);
+    const int t1 = std::floor(st[1] + 2 * inv_det * v_sqrt);
+
+    // Scan over ellipse bound and evaluate quadratic equation to filter image
+    constexpr FloatType alpha = 2;
+    const FloatType exp_alpha = std::exp(-alpha);
+
+    RGB sum(0, 0, 0);
+    FloatType sum_weights = 0;
+    for (int it = t0; it <= t1; ++it) {
+        const FloatType tt = it - st[1];
+        for (int is = s0; is <= s1; ++is) {
+            const FloatType ss = is - st[0];
+
+            // Compute squared radius and filter texel if it is inside the ellipse
+            const FloatType r2 = A * sqr(ss) + B * ss * tt + C * sqr(tt);
+            if (r2 < 1) {
+                const FloatType weight = std::exp(-alpha * r2) - exp_alpha;
+                sum += weight * texel(level, Point2i(is, it));
+                sum_weights += weight;
+            }
+        }
+    }
+
+    return sum_weights > 0 ? sum / sum_weights : bilerp(level, _st);
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <pbrt/euclidean_space/vector2.h>
 #include <pbrt/gpu/gpu_memory_allocator.h>
 #include <pbrt/scene/parameter_dictionary.h>
 #include <pbrt/spectrum_util/rgb.h>
@@ -54,29 +55,29 @@ class MIPMap {
         return mipmap;
     }
 
+    // dst0, dst1: screen-space derivatives of st, bounding the filter footprint
     PBRT_CPU_GPU
-    RGB filter(const Point2f st) const {
-        return image->bilerp(st, WrapMode2D(wrap_mode));
-    }
+    RGB filter(Point2f st, Vector2f dst0, Vector2f dst1) const;
 
   private:
-    const GPUImage *image;
+    const GPUImage *const *levels;
+    uint num_levels;
+
     WrapMode wrap_mode;
     MIPMapFilterOptions options;
 
-    void init(const ParameterDictionary &parameters, GPUMemoryAllocator &allocator) {
-        auto max_anisotropy = parameters.get_float("maxanisotropy", 8.0);
-        auto filter_string = parameters.get_one_string("filter", "bilinear");
+    PBRT_CPU_GPU
+    RGB texel(uint level, Point2i st) const {
+        return levels[level]->fetch_pixel(st, WrapMode2D(wrap_mode));
+    }
 
-        options = MIPMapFilterOptions{
-            .filter = parse_filter_function(filter_string),
-            .max_anisotropy = max_anisotropy,
-        };
+    PBRT_CPU_GPU
+    RGB bilerp(uint level, Point2f st) const {
+        return levels[level]->bilerp(st, WrapMode2D(wrap_mode));
+    }
 
-        auto wrap_string = parameters.get_one_string("wrap", "repeat");
-        wrap_mode = parse_wrap_mode(wrap_string);
+    PBRT_CPU_GPU
+    RGB ewa(uint level, Point2f st, Vector2f dst0, Vector2f dst1) const;
 
-        auto image_path = parameters.root + "/" + parameters.get_one_string("filename");
-        image = GPUImage::create_from_file(image_path, allocator);
-    }
+    void init(const ParameterDictionary &parameters, GPUMemoryAllocator &allocator);
 };
@@ -29,7 +29,7 @@ SampledSpectrum SpectrumImageTexture::evaluate(const TextureEvalContext &ctx,
     auto c = texture_mapping->map(ctx);
     c.st[1] = 1.0 - c.st[1];
 
-    auto _rgb = scale * mipmap->filter(c.st);
+    auto _rgb = scale * mipmap->filter(c.st, Vector2f(c.dsdx, c.dtdx), Vector2f(c.dsdy, c.dtdy));
     auto rgb = (invert ? RGB(1.0, 1.0, 1.0) - _rgb : _rgb).clamp(0.0, Infinity);
 
     switch (spectrum_type) {
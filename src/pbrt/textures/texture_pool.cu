@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <pbrt/gpu/gpu_memory_allocator.h>
+#include <pbrt/textures/texture_pool.h>
+#include <unistd.h>
+
+namespace {
+// a process renders a single scene, so there's a single pool: what only the host needs to
+// evict and reload tiles stays here
+std::vector<GPUImage *> pool_images;
+
+// (paged_idx, tile_idx) held by each slot, per pixel format
+std::vector<std::pair<uint, uint>> slot_owners[3];
+
+// a single path looking up a few textures through EWA at two levels doesn't need more
+constexpr uint MIN_SLOTS = 256;
+} // namespace
+
+TexturePool *TexturePool::create(const size_t budget_bytes,
+                                 const std::vector<GPUImage *> &paged_images,
+                                 GPUMemoryAllocator &allocator) {
+    size_t format_bytes[3] = {0, 0, 0};
+    uint format_tiles[3] = {0, 0, 0};
+    size_t tile_storage_sizes[3] = {0, 0, 0};
+    size_t total_bytes = 0;
+    uint total_tiles = 0;
+    for (const auto image : paged_images) {
+        const auto format_idx = static_cast<int>(image->pixel_format);
+        format_bytes[format_idx] += image->get_storage_size();
+        format_tiles[format_idx] += image->num_tiles;
+        tile_storage_sizes[format_idx] = image->get_tile_storage_size();
+        total_bytes += image->get_storage_size();
+        total_tiles += image->num_tiles;
+    }
+
+    auto pool = allocator.allocate<TexturePool>();
+    pool->current_stamp = 1;
+    pool->requests = allocator.allocate<TileRequest>(total_tiles);
+    pool->num_requests = 0;
+    pool->missed_lookups = nullptr;
+    pool->num_tracked_threads = 0;
+    pool->num_loaded_tiles = 0;
+    pool->num_evicted_tiles = 0;
+
+    // the budget is shared between pixel formats in proportion to their paged texels
+    size_t pool_bytes = 0;
+    for (uint format_idx = 0; format_idx < 3; ++format_idx) {
+        auto &slots = pool->slot_arrays[format_idx];
+        slots.texels = nullptr;
+        slots.last_used = nullptr;
+        slots.num_slots = 0;
+        slots.tile_storage_size = 0;
+
+        if (format_tiles[format_idx] == 0) {
+            continue;
+        }
+
+        slots.tile_storage_size = tile_storage_sizes[format_idx];
+        const auto budget_slots = size_t(double(budget_bytes) * format_bytes[format_idx] /
+                                         total_bytes / slots.tile_storage_size);
+        slots.num_slots = std::min<size_t>(std::max<size_t>(budget_slots, MIN_SLOTS),
+                                           format_tiles[format_idx]);
+
+        slots.texels = allocator.allocate<uint8_t>(slots.num_slots * slots.tile_storage_size);
+        slots.last_used = allocator.allocate<uint>(slots.num_slots);
+        std::fill(slots.last_used, slots.last_used + slots.num_slots, 0);
+
+        slot_owners[format_idx] = std::vector<std::pair<uint, uint>>(
+            slots.num_slots, {NOT_RESIDENT, NOT_RESIDENT});
+
+        pool_bytes += slots.num_slots * slots.tile_storage_size;
+    }
+
+    for (const auto image : paged_images) {
+        const auto texels = pool->slot_arrays[static_cast<int>(image->pixel_format)].texels;
+        image->pixels_u256 = image->pixel_format == PixelFormat::U256 ? texels : nullptr;
+        image->pixels_half = image->pixel_format == PixelFormat::Half
+                                 ? reinterpret_cast<const Half *>(texels)
+                                 : nullptr;
+        image->pixels_float = image->pixel_format == PixelFormat::Float
+                                  ? reinterpret_cast<const float *>(texels)
+                                  : nullptr;
+        image->texture_pool = pool;
+    }
+    pool_images = paged_images;
+
+    printf("texture pool: %.1f MB of device memory for %.1f MB of paged texels (%u levels)\n",
+           double(pool_bytes) / 1024 / 1024, double(total_bytes) / 1024 / 1024,
+           uint(paged_images.size()));
+
+    return pool;
+}
+
+void TexturePool::track_lookups(const uint num_threads, GPUMemoryAllocator &allocator) {
+    missed_lookups = allocator.allocate<bool>(num_threads);
+    std::fill(missed_lookups, missed_lookups + num_threads, false);
+    num_tracked_threads = num_threads;
+}
+
+bool TexturePool::load_requested_tiles() {
+    std::vector<TileRequest> format_requests[3];
+    for (uint idx = 0; idx < num_requests; ++idx) {
+        const auto &request = requests[idx];
+        const auto image = pool_images[request.paged_idx];
+        format_requests[static_cast<int>(image->pixel_format)].push_back(request);
+
+        // a request left without a slot is queued again by its next miss
+        image->tile_requested[request.tile_idx] = 0;
+    }
+    num_requests = 0;
+
+    // requests are grouped by image: each tile cache file is opened once per load
+    int file = -1;
+    uint file_idx = NOT_RESIDENT;
+
+    bool all_loaded = true;
+    for (uint format_idx = 0; format_idx < 3; ++format_idx) {
+        auto &tile_requests = format_requests[format_idx];
+        if (tile_requests.empty()) {
+            continue;
+        }
+
+        // neighbouring tiles of a level are next to each other in its tile cache file
+        std::sort(tile_requests.begin(), tile_requests.end(), [](const auto &a, const auto &b) {
+            return a.paged_idx != b.paged_idx ? a.paged_idx < b.paged_idx
+                                              : a.tile_idx < b.tile_idx;
+        });
+
+        const auto &slots = slot_arrays[format_idx];
+        auto &owners = slot_owners[format_idx];
+
+        // least recently used first, slots touched by the last launch are kept: the lookups run
+        // again next need them along with the tiles loaded now
+        std::vector<uint> victims;
+        for (uint slot = 0; slot < slots.num_slots; ++slot) {
+            if (slots.last_used[slot] < current_stamp) {
+                victims.push_back(slot);
+            }
+        }
+
+        const auto num_loaded = std::min(victims.size(), tile_requests.size());
+        std::partial_sort(victims.begin(), victims.begin() + num_loaded, victims.end(),
+                          [&](const uint a, const uint b) {
+                              return slots.last_used[a] < slots.last_used[b];
+                          });
+        all_loaded = all_loaded && num_loaded == tile_requests.size();
+
+        for (uint idx = 0; idx < num_loaded; ++idx) {
+            const auto slot = victims[idx];
+            const auto &request = tile_requests[idx];
+
+            if (const auto [owner_idx, owner_tile] = owners[slot]; owner_idx != NOT_RESIDENT) {
+                pool_images[owner_idx]->tile_slots[owner_tile] = NOT_RESIDENT;
+                num_evicted_tiles += 1;
+            }
+
+            const auto image = pool_images[request.paged_idx];
+            if (image->tile_file_idx != file_idx) {
+                if (file >= 0) {
+                    close(file);
+                }
+                file = image->open_tile_file();
+                file_idx = image->tile_file_idx;
+            }
+            image->read_tile(file, request.tile_idx,
+                             slots.texels + slot * slots.tile_storage_size);
+            image->tile_slots[request.tile_idx] = slot;
+
+            owners[slot] = {request.paged_idx, request.tile_idx};
+            slots.last_used[slot] = current_stamp;
+        }
+        num_loaded_tiles += num_loaded;
+    }
+
+    if (file >= 0) {
+        close(file);
+    }
+
+    return all_loaded;
+}
+
+void TexturePool::print_statistics() const {
+    printf("texture pool: %llu tiles loaded, %llu evicted\n", num_loaded_tiles,
+           num_evicted_tiles);
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <limits>
+#include <pbrt/gpu/macro.h>
+#include <pbrt/textures/gpu_image.h>
+#include <vector>
+
+class GPUMemoryAllocator;
+
+// decoded tiles of every paged MIP level (`--texture-cache-mb`): a fixed number of slots per
+// pixel format, filled on first access from the on-disk tile cache. once the pool is full, a new
+// tile takes the slot of the least recently used one.
+// a lookup missing its tile queues a request and returns black, flagging its thread: the caller
+// (the wavefront material stage) discards the result, loads the requested tiles between two
+// launches and runs the flagged lookups again
+class TexturePool {
+  public:
+    static constexpr uint NOT_RESIDENT = std::numeric_limits<uint>::max();
+
+    static TexturePool *create(size_t budget_bytes, const std::vector<GPUImage *> &paged_images,
+                               GPUMemoryAllocator &allocator);
+
+    // misses of the first `num_threads` threads of a launch are flagged per thread
+    void track_lookups(uint num_threads, GPUMemoryAllocator &allocator);
+
+    PBRT_GPU
+    void clear_missed(const uint thread_idx) {
+        missed_lookups[thread_idx] = false;
+    }
+
+    PBRT_GPU
+    bool has_missed(const uint thread_idx) const {
+        return missed_lookups[thread_idx];
+    }
+
+    PBRT_CPU_GPU
+    void request_tile(const GPUImage *image, const uint tile_idx) {
+#if defined(__CUDA_ARCH__)
+        const uint thread_idx = blockIdx.x * blockDim.x + threadIdx.x;
+        if (thread_idx < num_tracked_threads) {
+            missed_lookups[thread_idx] = true;
+        }
+
+        // only the first miss on a tile queues it
+        if (atomicExch(&image->tile_requested[tile_idx], 1) == 0) {
+            const uint request_idx = atomicAdd(&num_requests, 1);
+            requests[request_idx] = TileRequest{image->paged_idx, tile_idx};
+        }
+#else
+        // host code only reads resident images: MIP levels are built before they're paged
+        REPORT_FATAL_ERROR();
+#endif
+    }
+
+    PBRT_CPU_GPU
+    void touch(const PixelFormat pixel_format, const uint slot) {
+        auto &last_used = slot_arrays[static_cast<int>(pixel_format)].last_used[slot];
+        if (last_used != current_stamp) {
+            last_used = current_stamp;
+        }
+    }
+
+    // slots touched by lookups from now on are the most recently used
+    void begin_launch() {
+        current_stamp += 1;
+    }
+
+    // give every requested tile a slot, never evicting one touched by the last launch: returns
+    // false when some request didn't fit (it's queued again by its next miss)
+    bool load_requested_tiles();
+
+    void print_statistics() const;
+
+  private:
+    struct TileRequest {
+        uint paged_idx;
+        uint tile_idx;
+    };
+
+    struct SlotArray {
+        uint8_t *texels;
+        // stamp of the last launch touching the slot, 0 for a free slot
+        uint *last_used;
+        uint num_slots;
+        size_t tile_storage_size;
+    };
+
+    SlotArray slot_arrays[3];
+
+    // bumped by every begin_launch()
+    uint current_stamp;
+
+    TileRequest *requests;
+    uint num_requests;
+
+    bool *missed_lookups;
+    uint num_tracked_threads;
+
+    unsigned long long num_loaded_tiles;
+    unsigned long long num_evicted_tiles;
+};
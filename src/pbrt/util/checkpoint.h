@@ -0,0 +1,127 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <pbrt/gpu/macro.h>
+#include <string>
+#include <type_traits>
+
+struct CheckpointOption {
+    std::optional<std::string> checkpoint_file;
+    std::optional<std::string> resume_file;
+    // seconds between two checkpoints
+    FloatType interval = 600;
+    // hash of the scene description (integrator and sampler parameters included) and of the
+    // command line options overriding it: part of every checkpoint tag
+    uint64_t render_hash = 0;
+};
+
+// a checkpoint is a raw dump of trivially copyable arrays: they are read back in the order they
+// were written, each one prefixed by its length so a mismatched checkpoint is caught early
+
+namespace HIDDEN {
+constexpr char CHECKPOINT_MAGIC[] = "pbrt-minus checkpoint";
+}
+
+class CheckpointWriter {
+  public:
+    // tag describes the render (integrator, resolution, spp...) and must match when resuming
+    CheckpointWriter(const std::string &_filename, const std::string &tag)
+        : filename(_filename), temp_filename(_filename + ".tmp"),
+          file(temp_filename, std::ios::binary | std::ios::trunc) {
+        if (!file.is_open()) {
+            printf("\n%s(): fail to open `%s`\n", __func__, temp_filename.c_str());
+            REPORT_FATAL_ERROR();
+        }
+
+        write(HIDDEN::CHECKPOINT_MAGIC, sizeof(HIDDEN::CHECKPOINT_MAGIC));
+        write(tag.data(), tag.size());
+    }
+
+    template <typename T>
+    void write(const T *data, const size_t num) {
+        static_assert(std::is_trivially_copyable_v<T>);
+
+        file.write(reinterpret_cast<const char *>(&num), sizeof(num));
+        file.write(reinterpret_cast<const char *>(data), sizeof(T) * num);
+    }
+
+    template <typename T>
+    void write(const T &value) {
+        write(&value, 1);
+    }
+
+    // the previous checkpoint is only replaced once the new one is complete
+    void commit() {
+        file.close();
+        if (file.fail()) {
+            printf("\n%s(): fail to write `%s`\n", __func__, temp_filename.c_str());
+            REPORT_FATAL_ERROR();
+        }
+
+        std::filesystem::rename(temp_filename, filename);
+    }
+
+  private:
+    std::string filename;
+    std::string temp_filename;
+    std::ofstream file;
+};
+
+class CheckpointReader {
+  public:
+    CheckpointReader(const std::string &_filename, const std::string &tag)
+        : filename(_filename), file(_filename, std::ios::binary) {
+        if (!file.is_open()) {
+            printf("\n%s(): fail to open `%s`\n", __func__, filename.c_str());
+            REPORT_FATAL_ERROR();
+        }
+
+        char magic[sizeof(HIDDEN::CHECKPOINT_MAGIC)];
+        read(magic, sizeof(magic));
+        if (std::string(magic) != HIDDEN::CHECKPOINT_MAGIC) {
+            printf("\n%s(): `%s` is not a checkpoint\n", __func__, filename.c_str());
+            REPORT_FATAL_ERROR();
+        }
+
+        size_t tag_size = 0;
+        file.read(reinterpret_cast<char *>(&tag_size), sizeof(tag_size));
+        std::string stored_tag(file ? tag_size : 0, '\0');
+        file.read(stored_tag.data(), stored_tag.size());
+        if (!file || stored_tag != tag) {
+            printf("\n%s(): `%s` was written for a different render (expect `%s`)\n", __func__,
+                   filename.c_str(), tag.c_str());
+            REPORT_FATAL_ERROR();
+        }
+    }
+
+    template <typename T>
+    void read(T *data, const size_t num) {
+        static_assert(std::is_trivially_copyable_v<T>);
+
+        size_t stored_num = 0;
+        file.read(reinterpret_cast<char *>(&stored_num), sizeof(stored_num));
+        if (!file || stored_num != num) {
+            printf("\n%s(): `%s` is truncated or corrupted\n", __func__, filename.c_str());
+            REPORT_FATAL_ERROR();
+        }
+
+        file.read(reinterpret_cast<char *>(data), sizeof(T) * num);
+        if (!file) {
+            printf("\n%s(): `%s` is truncated\n", __func__, filename.c_str());
+            REPORT_FATAL_ERROR();
+        }
+    }
+
+    template <typename T>
+    T read() {
+        T value;
+        read(&value, 1);
+        return value;
+    }
+
+  private:
+    std::string filename;
+    std::ifstream file;
+};